@@ -0,0 +1,151 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <net/gather_list.h>
+
+#include <net/protocol/ymsg/ymsg_frame_builder.h>
+
+namespace bench {
+    /**
+     * @brief Gets the number of allocations made through operator new so far, by any thread.
+     * @return The allocation count.
+     */
+    std::uint64_t allocation_count();
+
+    /**
+     * @brief Reports the allocations made while it is alive, per iteration, as the "allocs/op" counter of a
+     * benchmark.
+     */
+    struct allocation_counter {
+        explicit allocation_counter(benchmark::State &state) : state_(state), start_(allocation_count()) {}
+
+        ~allocation_counter() {
+            state_.counters["allocs/op"] = benchmark::Counter(static_cast<double>(allocation_count() - start_),
+                                                              benchmark::Counter::kAvgIterations);
+        }
+
+        allocation_counter(const allocation_counter &) = delete;
+        allocation_counter &operator=(const allocation_counter &) = delete;
+
+    private:
+        benchmark::State &state_;
+        std::uint64_t start_;
+    };
+
+    using field_list = std::vector<std::pair<net::protocol::YMSG_FLD_, std::string>>;
+
+    /**
+     * @brief Field mixes modelled on real traffic, selected by index: 0 is a login request of short fields, 1 a
+     * chat message of about 4 KB and 2 a buddy list of about 60 KB.
+     * @param index The index of the mix.
+     * @return The fields.
+     */
+    inline const field_list &field_mix(std::int64_t index) {
+        const auto field = [](std::uint16_t key, std::string value) {
+            return std::pair(static_cast<net::protocol::YMSG_FLD_>(key), std::move(value));
+        };
+
+        static const auto mixes = [&] {
+            std::vector<field_list> result;
+
+            result.push_back({
+                    field(0, "someone"),
+                    field(1, "someone"),
+                    field(6, "Tq9WcbdM3GkqvgVbH1RzDm1fxWlFqY6pA0d0v8XwpQ4-"),
+                    field(96, "Zt3Xg1f1gi9a8pUwbx1ADg--"),
+                    field(2, "someone"),
+                    field(2, "1"),
+                    field(244, "4194239"),
+                    field(135, "9.0.0.2162"),
+                    field(148, "-60"),
+                    field(59, "B\t4rpfc8dgi5kbb&b=4&s=hc"),
+            });
+
+            result.push_back({
+                    field(1, "someone"),
+                    field(5, "someone_else"),
+                    field(14, std::string(4000, 'x')),
+                    field(97, "1"),
+                    field(63, ";0"),
+                    field(64, "0"),
+                    field(206, "2"),
+            });
+
+            field_list buddies{field(1, "someone"), field(89, "someone")};
+            for (std::size_t group = 0; buddies.size() < 5400; group++) {
+                buddies.push_back(field(302, "318"));
+                buddies.push_back(field(300, "318"));
+                buddies.push_back(field(65, "Group " + std::to_string(group)));
+
+                for (std::size_t i = 0; i < 25; i++) {
+                    buddies.push_back(field(302, "319"));
+                    buddies.push_back(field(300, "319"));
+                    buddies.push_back(field(7, "buddy_" + std::to_string(group) + "_" + std::to_string(i)));
+                    buddies.push_back(field(301, "319"));
+                }
+
+                buddies.push_back(field(301, "318"));
+            }
+
+            result.push_back(std::move(buddies));
+            return result;
+        }();
+
+        return mixes.at(index);
+    }
+
+    inline const char *field_mix_name(std::int64_t index) {
+        constexpr const char *NAMES[] = {"login", "chat_4k", "buddy_list_60k"};
+        return NAMES[index];
+    }
+
+    /**
+     * @brief Encodes a frame, header and body, into one buffer.
+     * @param type The message type.
+     * @param fields The fields of the body.
+     * @return The frame.
+     */
+    inline std::vector<std::byte> encode_frame(net::protocol::YES_ type, const field_list &fields) {
+        net::protocol::ymsg_frame_builder builder(type);
+        for (const auto &[key, value]: fields) {
+            builder.add(key, value);
+        }
+
+        std::vector<std::byte> frame;
+        builder.finish().for_each_segment([&](std::span<const std::byte> data) {
+            frame.insert(frame.end(), data.begin(), data.end());
+        });
+
+        return frame;
+    }
+}  // namespace bench
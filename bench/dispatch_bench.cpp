@@ -0,0 +1,119 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <bench_util.h>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#include <server/connection.h>
+#include <server/event_loop.h>
+#include <server/server.h>
+
+#include <net/protocol/ymsg/ymsg_field_view.h>
+
+using namespace net::protocol;
+
+namespace {
+    constexpr std::size_t HEADER_SIZE = sizeof(ymsg_frame_header);
+
+    /**
+     * @brief Event loop that never runs, so that connections can be driven by hand.
+     */
+    struct idle_loop final : server::event_loop {
+        idle_loop() : event_loop(0, sessions_, router_) {}
+
+        bool run() override {
+            return true;
+        }
+
+        void schedule_flush(server::connection &) override {}
+
+    private:
+        // the base only keeps references, so it may be handed these before they are constructed
+        server::session_table sessions_{1};
+        server::message_router router_{1};
+    };
+
+    /**
+     * @brief Runs frames of one type through the whole dispatch path: registry lookup, state check, field
+     * validation, the handler and its reply. Replies are dropped after every frame.
+     * @param username If not empty, the connection is logged in under this name first.
+     */
+    void dispatch(benchmark::State &state, YES_ type, const bench::field_list &fields,
+                  std::string_view username = {}) {
+        idle_loop loop;
+
+        const net::endpoint endpoint("127.0.0.1", 1);
+        loop.admission().admit(loop.admission().find(endpoint), 0);
+
+        server::connection conn(loop, 1, net::socket(), endpoint);
+
+        if (!username.empty()) {
+            conn.logged_in(username);
+        }
+
+        const auto frame = bench::encode_frame(type, fields);
+        net::deserializer data(frame);
+        ymsg_header header;
+        header.deserialize(data);
+
+        const auto body = std::span(frame).subspan(HEADER_SIZE);
+
+        bench::allocation_counter allocations(state);
+
+        for (auto _: state) {
+            const ymsg_frame_view view(body);
+            benchmark::DoNotOptimize(server::handle_frame(conn, header, view));
+
+            auto &outbound = conn.outbound();
+            outbound.consume(outbound.size());
+        }
+
+        state.SetBytesProcessed(state.iterations() * frame.size());
+    }
+
+    void BM_dispatch_helo(benchmark::State &state) {
+        dispatch(state, YES_HELO, {{static_cast<YMSG_FLD_>(1), "someone"}});
+    }
+    BENCHMARK(BM_dispatch_helo);
+
+    void BM_dispatch_keep_alive(benchmark::State &state) {
+        dispatch(state, YES_KEEP_ALIVE, {{static_cast<YMSG_FLD_>(0), "someone"}});
+    }
+    BENCHMARK(BM_dispatch_keep_alive);
+
+    void BM_dispatch_unknown(benchmark::State &state) {
+        dispatch(state, YES_SAY_CONFERENCE, bench::field_mix(1));
+    }
+    BENCHMARK(BM_dispatch_unknown);
+
+    // an instant message to the sender itself, so that it is delivered without leaving the loop
+    void BM_dispatch_message(benchmark::State &state) {
+        dispatch(state, YES_USER_HAS_MSG, {{YMSG_FLD_CURRENT_ID, "someone"},
+                                           {YMSG_FLD_TARGET_USER, "someone"},
+                                           {YMSG_FLD_MSG, std::string(256, 'x')},
+                                           {YMSG_FLD_UTF8_FLAG, "1"}}, "someone");
+    }
+    BENCHMARK(BM_dispatch_message);
+}  // namespace
@@ -0,0 +1,200 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <bench_util.h>
+
+#include <net/packet.h>
+
+#include <net/protocol/ymsg/ymsg_field.h>
+#include <net/protocol/ymsg/ymsg_field_view.h>
+#include <net/protocol/ymsg/ymsg_header.h>
+
+using namespace net::protocol;
+
+namespace {
+    constexpr std::size_t HEADER_SIZE = sizeof(ymsg_frame_header);
+
+    const ymsg_header SAMPLE_HEADER(16, 0, 512, YES_USER_HAS_MSG, YES_STATUS_OK, 0x12345678);
+
+    void BM_header_serialize(benchmark::State &state) {
+        bench::allocation_counter allocations(state);
+
+        for (auto _: state) {
+            net::serializer s;
+            SAMPLE_HEADER.serialize(s);
+            benchmark::DoNotOptimize(s.data().data());
+        }
+
+        state.SetBytesProcessed(state.iterations() * HEADER_SIZE);
+    }
+    BENCHMARK(BM_header_serialize);
+
+    void BM_header_deserialize(benchmark::State &state) {
+        net::serializer s;
+        SAMPLE_HEADER.serialize(s);
+        const auto data = s.data();
+
+        bench::allocation_counter allocations(state);
+
+        for (auto _: state) {
+            net::deserializer d(data);
+            ymsg_header header;
+            benchmark::DoNotOptimize(header.deserialize(d));
+            benchmark::DoNotOptimize(header);
+        }
+
+        state.SetBytesProcessed(state.iterations() * HEADER_SIZE);
+    }
+    BENCHMARK(BM_header_deserialize);
+
+    void BM_serializer_emplace(benchmark::State &state) {
+        bench::allocation_counter allocations(state);
+
+        for (auto _: state) {
+            net::serializer s;
+            s.emplace<ymsg_header>(16, 0, 512, YES_USER_HAS_MSG, YES_STATUS_OK, 0x12345678);
+            s.emplace<ymsg_field>(static_cast<YMSG_FLD_>(14), "hello there");
+            benchmark::DoNotOptimize(s.data().data());
+        }
+    }
+    BENCHMARK(BM_serializer_emplace);
+
+    /**
+     * @brief Parses every field of a body into owning ymsg_field objects.
+     */
+    void BM_field_parse(benchmark::State &state) {
+        const auto frame = bench::encode_frame(YES_USER_HAS_MSG, bench::field_mix(state.range(0)));
+        const auto body = std::span(frame).subspan(HEADER_SIZE);
+
+        state.SetLabel(bench::field_mix_name(state.range(0)));
+        bench::allocation_counter allocations(state);
+
+        for (auto _: state) {
+            net::deserializer d(body);
+            ymsg_field field;
+
+            while (d.size() > 0 && field.deserialize(d)) {
+                benchmark::DoNotOptimize(field.value.data());
+            }
+        }
+
+        state.SetBytesProcessed(state.iterations() * body.size());
+    }
+    BENCHMARK(BM_field_parse)->DenseRange(0, 2);
+
+    /**
+     * @brief Walks every field of a body in place, as the handlers do.
+     */
+    void BM_field_view_parse(benchmark::State &state) {
+        const auto frame = bench::encode_frame(YES_USER_HAS_MSG, bench::field_mix(state.range(0)));
+        const auto body = std::span(frame).subspan(HEADER_SIZE);
+
+        state.SetLabel(bench::field_mix_name(state.range(0)));
+        bench::allocation_counter allocations(state);
+
+        for (auto _: state) {
+            const ymsg_frame_view fields(body);
+
+            for (const auto &field: fields) {
+                benchmark::DoNotOptimize(field.value.data());
+            }
+        }
+
+        state.SetBytesProcessed(state.iterations() * body.size());
+    }
+    BENCHMARK(BM_field_view_parse)->DenseRange(0, 2);
+
+    /**
+     * @brief Encodes every field of a body through ymsg_field objects.
+     */
+    void BM_field_encode(benchmark::State &state) {
+        const auto &fields = bench::field_mix(state.range(0));
+        const auto body_size = bench::encode_frame(YES_USER_HAS_MSG, fields).size() - HEADER_SIZE;
+
+        state.SetLabel(bench::field_mix_name(state.range(0)));
+        bench::allocation_counter allocations(state);
+
+        for (auto _: state) {
+            net::serializer s;
+
+            for (const auto &[key, value]: fields) {
+                s.emplace<ymsg_field>(key, value);
+            }
+
+            benchmark::DoNotOptimize(s.data().data());
+        }
+
+        state.SetBytesProcessed(state.iterations() * body_size);
+    }
+    BENCHMARK(BM_field_encode)->DenseRange(0, 2);
+
+    /**
+     * @brief Encodes a whole frame through the frame builder, as the handlers do.
+     */
+    void BM_frame_builder(benchmark::State &state) {
+        const auto &fields = bench::field_mix(state.range(0));
+        const auto frame_size = bench::encode_frame(YES_USER_HAS_MSG, fields).size();
+
+        state.SetLabel(bench::field_mix_name(state.range(0)));
+        bench::allocation_counter allocations(state);
+
+        for (auto _: state) {
+            ymsg_frame_builder builder(YES_USER_HAS_MSG);
+
+            for (const auto &[key, value]: fields) {
+                builder.add(key, value);
+            }
+
+            auto frame = builder.finish();
+            benchmark::DoNotOptimize(frame.size());
+        }
+
+        state.SetBytesProcessed(state.iterations() * frame_size);
+    }
+    BENCHMARK(BM_frame_builder)->DenseRange(0, 2);
+
+    /**
+     * @brief Finds a field separator at the end of a buffer of the given size, split in two halves as it is when
+     * a frame wraps around the end of the receive buffer.
+     */
+    void BM_find_pattern_first(benchmark::State &state) {
+        const auto size = static_cast<std::size_t>(state.range(0));
+
+        std::vector<std::byte> data(size, std::byte{'a'});
+        data[size - 2] = std::byte{0xC0};
+        data[size - 1] = std::byte{0x80};
+
+        const auto split = size / 2;
+        const auto first = std::span(data).first(split);
+        const auto second = std::span(data).subspan(split);
+
+        bench::allocation_counter allocations(state);
+
+        for (auto _: state) {
+            net::deserializer d(first, second);
+            benchmark::DoNotOptimize(d.find_pattern_first(YMSG_FIELD_SEPARATOR));
+        }
+
+        state.SetBytesProcessed(state.iterations() * size);
+    }
+    BENCHMARK(BM_find_pattern_first)->RangeMultiplier(8)->Range(64, 64 << 10);
+}  // namespace
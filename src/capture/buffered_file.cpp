@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <capture/buffered_file.h>
+
+#include <logging/logging.h>
+
+namespace capture {
+    namespace {
+        constexpr std::size_t WRITE_BUFFER_SIZE = 256 * 1024;
+        constexpr std::chrono::seconds FLUSH_INTERVAL{1};
+    }  // namespace
+
+    std::unique_ptr<buffered_file> buffered_file::create(const std::string &path) {
+        auto *file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            logging::system()->error("Failed to create {0}!", path);
+            return nullptr;
+        }
+
+        return std::unique_ptr<buffered_file>(new buffered_file(file, path));
+    }
+
+    buffered_file::buffered_file(std::FILE *file, std::string path)
+      : file_(file), path_(std::move(path)), buffer_(WRITE_BUFFER_SIZE), last_flush_(std::chrono::steady_clock::now()) {
+        std::setvbuf(file_, buffer_.data(), _IOFBF, buffer_.size());
+    }
+
+    buffered_file::~buffered_file() {
+        std::fclose(file_);
+    }
+
+    void buffered_file::write(const void *data, std::size_t length) {
+        if (failed_ || length == 0) {
+            return;
+        }
+
+        if (std::fwrite(data, 1, length, file_) != length) {
+            logging::system()->error("Failed to write to {0}, recording stopped!", path_);
+            failed_ = true;
+        }
+    }
+
+    void buffered_file::flush_if_due() {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_flush_ >= FLUSH_INTERVAL) {
+            std::fflush(file_);
+            last_flush_ = now;
+        }
+    }
+}  // namespace capture
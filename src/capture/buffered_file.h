@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace capture {
+    /**
+     * @brief File written through a large buffer, for recording from an event loop thread.
+     * @note Not thread safe. A failed write is logged once, and every later write is dropped.
+     */
+    struct buffered_file {
+        /**
+         * @brief Creates a file, truncating it if it exists.
+         * @param path The path of the file.
+         * @return The file, or nullptr if it couldn't be created.
+         */
+        static std::unique_ptr<buffered_file> create(const std::string &path);
+
+        /**
+         * @brief Destructor; flushes and closes the file.
+         */
+        ~buffered_file();
+
+        buffered_file(const buffered_file &) = delete;
+        buffered_file &operator=(const buffered_file &) = delete;
+
+        /**
+         * @brief Appends data to the file.
+         * @param data The data.
+         * @param length The length of the data.
+         */
+        void write(const void *data, std::size_t length);
+
+        /**
+         * @brief Flushes the buffer if it wasn't flushed for a second; call between records, so that a file read
+         * while it is being written rarely ends in the middle of one.
+         */
+        void flush_if_due();
+
+        /**
+         * @brief Checks whether a write failed.
+         * @return true if writes are being dropped, false otherwise.
+         */
+        bool failed() const {
+            return failed_;
+        }
+
+    private:
+        buffered_file(std::FILE *file, std::string path);
+
+        std::FILE *file_;
+        std::string path_;
+        std::vector<char> buffer_;
+        bool failed_ = false;
+
+        std::chrono::steady_clock::time_point last_flush_;
+    };
+}  // namespace capture
@@ -0,0 +1,144 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace capture {
+    // capture files start with a file_header, followed by records: a record_header, then the raw frame, header
+    // and body as they were on the wire, padded to RECORD_ALIGNMENT. Every record header is thus aligned when the
+    // file is mapped into memory, and readers walk the records without copying them. Integers outside of the frames
+    // are in host byte order
+
+    constexpr std::array<char, 8> FILE_MAGIC = {'Y', 'M', 'C', 'A', 'P', 'T', 'R', '\0'};
+    constexpr std::uint32_t FORMAT_VERSION = 1;
+    constexpr std::size_t RECORD_ALIGNMENT = 8;
+
+    enum class direction : std::uint8_t {
+        // a frame sent by the client
+        inbound,
+        // a frame queued for the client
+        outbound,
+        // the connection was closed; the record carries no frame
+        closed,
+    };
+
+    struct file_header {
+        std::array<char, 8> magic = FILE_MAGIC;
+        std::uint32_t version = FORMAT_VERSION;
+
+        // index of the event loop that wrote the file
+        std::uint32_t shard = 0;
+
+        // wall clock time the capture started, in nanoseconds since the Unix epoch
+        std::int64_t started_at = 0;
+    };
+
+    struct record_header {
+        std::uint64_t connection_id = 0;
+
+        // steady clock time of the record, in nanoseconds; comparable across the files of one capture
+        std::uint64_t timestamp = 0;
+
+        // length of the frame that follows, without padding
+        std::uint32_t length = 0;
+        direction dir = direction::inbound;
+        std::array<std::uint8_t, 3> reserved{};
+    };
+
+    static_assert(sizeof(file_header) % RECORD_ALIGNMENT == 0);
+    static_assert(sizeof(record_header) % RECORD_ALIGNMENT == 0);
+
+    /**
+     * @brief Gets the space a frame takes in a capture file.
+     * @param length The length of the frame.
+     * @return The length, rounded up to RECORD_ALIGNMENT.
+     */
+    constexpr std::size_t padded_length(std::size_t length) {
+        return (length + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+    }
+
+    struct record {
+        const record_header *header;
+        std::span<const std::byte> frame;
+    };
+
+    /**
+     * @brief Walks the records of a capture file loaded or mapped into memory.
+     * @note A record cut short, as by a server that died while writing it, ends the walk.
+     */
+    struct record_cursor {
+        /**
+         * @brief Constructor.
+         * @param data The whole file; must be aligned to RECORD_ALIGNMENT.
+         */
+        explicit record_cursor(std::span<const std::byte> data) : data_(data) {}
+
+        /**
+         * @brief Gets the file header.
+         * @return The file header, or nullptr if the data isn't a capture file of a supported version.
+         */
+        const file_header *header() const {
+            if (data_.size() < sizeof(file_header)) {
+                return nullptr;
+            }
+
+            const auto *header = reinterpret_cast<const file_header *>(data_.data());
+            if (header->magic != FILE_MAGIC || header->version != FORMAT_VERSION) {
+                return nullptr;
+            }
+
+            return header;
+        }
+
+        /**
+         * @brief Reads the next record.
+         * @return The record, or std::nullopt at the end of the file.
+         */
+        std::optional<record> next() {
+            if (offset_ > data_.size() || data_.size() - offset_ < sizeof(record_header)) {
+                return std::nullopt;
+            }
+
+            const auto *header = reinterpret_cast<const record_header *>(data_.data() + offset_);
+            const auto frame_offset = offset_ + sizeof(record_header);
+
+            if (data_.size() - frame_offset < header->length) {
+                return std::nullopt;
+            }
+
+            offset_ = std::min(data_.size(), frame_offset + padded_length(header->length));
+            return record{header, data_.subspan(frame_offset, header->length)};
+        }
+
+    private:
+        std::span<const std::byte> data_;
+        std::size_t offset_ = sizeof(file_header);
+    };
+}  // namespace capture
@@ -0,0 +1,105 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <capture/recorder.h>
+
+#include <array>
+#include <chrono>
+
+namespace capture {
+    std::unique_ptr<recorder> recorder::open(const std::string &path, std::uint32_t shard) {
+        auto file = buffered_file::create(path + "." + std::to_string(shard));
+        if (file == nullptr) {
+            return nullptr;
+        }
+
+        std::unique_ptr<recorder> result(new recorder(std::move(file)));
+
+        file_header header;
+        header.shard = shard;
+        header.started_at = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::system_clock::now().time_since_epoch())
+                                    .count();
+
+        result->file_->write(&header, sizeof(header));
+        return result;
+    }
+
+    recorder::recorder(std::unique_ptr<buffered_file> file) : file_(std::move(file)) {}
+
+    void recorder::inbound(std::uint64_t connection_id, const net::protocol::ymsg_header &header,
+                           std::span<const std::byte> body) {
+        net::serializer s;
+        header.serialize(s);
+
+        const auto head = s.data();
+        const auto length = head.size() + body.size();
+        if (!begin_record(connection_id, direction::inbound, length)) {
+            return;
+        }
+
+        file_->write(head.data(), head.size());
+        file_->write(body.data(), body.size());
+        end_record(length);
+    }
+
+    void recorder::outbound(std::uint64_t connection_id, const net::gather_list &frame) {
+        if (!begin_record(connection_id, direction::outbound, frame.size())) {
+            return;
+        }
+
+        frame.for_each_segment([this](std::span<const std::byte> data) {
+            file_->write(data.data(), data.size());
+        });
+
+        end_record(frame.size());
+    }
+
+    void recorder::closed(std::uint64_t connection_id) {
+        if (begin_record(connection_id, direction::closed, 0)) {
+            end_record(0);
+        }
+    }
+
+    bool recorder::begin_record(std::uint64_t connection_id, direction dir, std::size_t length) {
+        if (file_->failed()) {
+            return false;
+        }
+
+        record_header header;
+        header.connection_id = connection_id;
+        header.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count();
+        header.length = static_cast<std::uint32_t>(length);
+        header.dir = dir;
+
+        file_->write(&header, sizeof(header));
+        return !file_->failed();
+    }
+
+    void recorder::end_record(std::size_t length) {
+        constexpr std::array<std::byte, RECORD_ALIGNMENT> padding{};
+        file_->write(padding.data(), padded_length(length) - length);
+        file_->flush_if_due();
+    }
+}  // namespace capture
@@ -0,0 +1,99 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+#include <capture/buffered_file.h>
+#include <capture/format.h>
+
+#include <net/gather_list.h>
+
+#include <net/protocol/ymsg/ymsg_header.h>
+
+namespace capture {
+    /**
+     * @brief Appends the frames of the connections of one event loop to a capture file.
+     * @note Not thread safe; every event loop records into a file of its own, so that recording takes no locks.
+     * Writes are buffered and reach the file at least once a second, and when the recorder is destroyed.
+     */
+    struct recorder {
+        /**
+         * @brief Creates the capture file of an event loop.
+         * @param path The path of the capture; the shard index is appended to it, as in "<path>.<shard>".
+         * @param shard Index of the event loop among the loops of the server.
+         * @return The recorder, or nullptr if the file couldn't be created.
+         */
+        static std::unique_ptr<recorder> open(const std::string &path, std::uint32_t shard);
+
+        recorder(const recorder &) = delete;
+        recorder &operator=(const recorder &) = delete;
+
+        /**
+         * @brief Records a frame received from a client.
+         * @param connection_id The ID of the connection.
+         * @param header The header of the frame.
+         * @param body The body of the frame.
+         */
+        void inbound(std::uint64_t connection_id, const net::protocol::ymsg_header &header,
+                     std::span<const std::byte> body);
+
+        /**
+         * @brief Records a frame queued for a client.
+         * @param connection_id The ID of the connection.
+         * @param frame The segments of the frame.
+         */
+        void outbound(std::uint64_t connection_id, const net::gather_list &frame);
+
+        /**
+         * @brief Records the end of a connection.
+         * @param connection_id The ID of the connection.
+         */
+        void closed(std::uint64_t connection_id);
+
+        /**
+         * @brief Flushes the records written so far if the file wasn't flushed for a second; called by the event
+         * loop every tick, so that the records of an idle loop reach the file as well.
+         */
+        void flush_if_due() {
+            file_->flush_if_due();
+        }
+
+    private:
+        explicit recorder(std::unique_ptr<buffered_file> file);
+
+        /**
+         * @brief Starts a record; the caller writes the frame, then finishes the record with end_record().
+         * @return false if recording failed earlier, true otherwise.
+         */
+        bool begin_record(std::uint64_t connection_id, direction dir, std::size_t length);
+
+        void end_record(std::size_t length);
+
+        std::unique_ptr<buffered_file> file_;
+    };
+}  // namespace capture
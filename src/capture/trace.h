@@ -0,0 +1,107 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <capture/buffered_file.h>
+
+namespace capture {
+    // trace files start with a trace_header, followed by fixed-size span records in host byte order; they are
+    // turned into Chrome trace JSON, which Perfetto opens too, by ymredux-trace2json
+
+    constexpr std::array<char, 8> TRACE_MAGIC = {'Y', 'M', 'T', 'R', 'A', 'C', 'E', '\0'};
+    constexpr std::uint32_t TRACE_FORMAT_VERSION = 1;
+
+    struct trace_header {
+        std::array<char, 8> magic = TRACE_MAGIC;
+        std::uint32_t version = TRACE_FORMAT_VERSION;
+
+        // index of the event loop that wrote the file
+        std::uint32_t shard = 0;
+
+        // wall clock time the trace started, in nanoseconds since the Unix epoch
+        std::int64_t started_at = 0;
+    };
+
+    /**
+     * @brief The dispatch of one frame, from the moment it was taken out of the stream to the end of its handler.
+     */
+    struct trace_span {
+        std::uint64_t connection_id = 0;
+
+        // steady clock time, in nanoseconds; comparable across the files of one trace
+        std::uint64_t begin = 0;
+        std::uint32_t duration = 0;
+
+        std::uint16_t type = 0;
+
+        // a server::frame_outcome
+        std::uint8_t outcome = 0;
+        std::uint8_t reserved = 0;
+    };
+
+    static_assert(sizeof(trace_span) == 24);
+
+    /**
+     * @brief Appends the frame spans of one event loop to a trace file.
+     * @note Not thread safe; every event loop traces into a file of its own.
+     */
+    struct tracer {
+        /**
+         * @brief Creates the trace file of an event loop.
+         * @param path The path of the trace; the shard index is appended to it, as in "<path>.<shard>".
+         * @param shard Index of the event loop among the loops of the server.
+         * @return The tracer, or nullptr if the file couldn't be created.
+         */
+        static std::unique_ptr<tracer> open(const std::string &path, std::uint32_t shard);
+
+        tracer(const tracer &) = delete;
+        tracer &operator=(const tracer &) = delete;
+
+        /**
+         * @brief Records a span.
+         * @param span The span.
+         */
+        void record(const trace_span &span) {
+            file_->write(&span, sizeof(span));
+            file_->flush_if_due();
+        }
+
+        /**
+         * @brief Flushes the spans written so far if the file wasn't flushed for a second.
+         */
+        void flush_if_due() {
+            file_->flush_if_due();
+        }
+
+    private:
+        explicit tracer(std::unique_ptr<buffered_file> file) : file_(std::move(file)) {}
+
+        std::unique_ptr<buffered_file> file_;
+    };
+}  // namespace capture
@@ -0,0 +1,181 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <logging/async_ring_sink.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include <fmt/format.h>
+
+namespace logging {
+    async_ring_sink::async_ring_sink(std::shared_ptr<spdlog::sinks::sink> target, std::size_t capacity,
+                                     overflow_policy overflow)
+      : target_(std::move(target)), overflow_(overflow) {
+        capacity = std::bit_ceil(std::max<std::size_t>(capacity, 2));
+
+        slots_ = std::make_unique<slot[]>(capacity);
+        mask_ = capacity - 1;
+
+        for (std::size_t i = 0; i < capacity; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        writer_ = std::thread([this] { run(); });
+    }
+
+    async_ring_sink::~async_ring_sink() {
+        stopping_.store(true);
+        wakeups_.fetch_add(1);
+        wakeups_.notify_one();
+
+        writer_.join();
+    }
+
+    void async_ring_sink::log(const spdlog::details::log_msg &msg) {
+        auto position = enqueue_position_.load(std::memory_order_relaxed);
+        slot *s;
+
+        while (true) {
+            s = &slots_[position & mask_];
+            const auto sequence = s->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::int64_t>(sequence - position);
+
+            if (difference == 0) {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                // full; the slot still holds the message from one lap ago
+                if (overflow_ == overflow_policy::drop) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                std::this_thread::yield();
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            } else {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+
+        s->time = msg.time;
+        s->thread_id = msg.thread_id;
+        s->level = msg.level;
+
+        s->logger_name_length = static_cast<std::uint8_t>(std::min(msg.logger_name.size(), MAX_LOGGER_NAME_LENGTH));
+        std::memcpy(s->logger_name, msg.logger_name.data(), s->logger_name_length);
+
+        s->length = static_cast<std::uint16_t>(std::min(msg.payload.size(), MAX_MESSAGE_LENGTH));
+        std::memcpy(s->text, msg.payload.data(), s->length);
+
+        s->sequence.store(position + 1, std::memory_order_release);
+
+        // pairs with the fence in run(): either the writer sees the message, or this sees it going to sleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed)) {
+            wakeups_.fetch_add(1, std::memory_order_release);
+            wakeups_.notify_one();
+        }
+    }
+
+    void async_ring_sink::flush() {
+        const auto position = enqueue_position_.load();
+
+        while (dequeue_position_.load(std::memory_order_acquire) < position && !stopping_.load()) {
+            std::this_thread::yield();
+        }
+
+        target_->flush();
+    }
+
+    void async_ring_sink::set_pattern(const std::string &pattern) {
+        target_->set_pattern(pattern);
+    }
+
+    void async_ring_sink::set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) {
+        target_->set_formatter(std::move(sink_formatter));
+    }
+
+    void async_ring_sink::run() {
+        while (true) {
+            const auto wakeups = wakeups_.load(std::memory_order_acquire);
+
+            if (drain()) {
+                continue;
+            }
+
+            target_->flush();
+
+            if (stopping_.load()) {
+                // a message may have been queued between the drain and the check
+                drain();
+                target_->flush();
+                return;
+            }
+
+            // announce the nap, then look once more, so that a message queued in between isn't slept through
+            sleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!drain()) {
+                wakeups_.wait(wakeups, std::memory_order_acquire);
+            }
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    bool async_ring_sink::drain() {
+        auto position = dequeue_position_.load(std::memory_order_relaxed);
+        bool any = false;
+
+        while (true) {
+            auto &s = slots_[position & mask_];
+            if (s.sequence.load(std::memory_order_acquire) != position + 1) {
+                break;
+            }
+
+            spdlog::details::log_msg msg(s.time, spdlog::source_loc{},
+                                         spdlog::string_view_t(s.logger_name, s.logger_name_length), s.level,
+                                         spdlog::string_view_t(s.text, s.length));
+            msg.thread_id = s.thread_id;
+
+            if (target_->should_log(msg.level)) {
+                target_->log(msg);
+            }
+
+            s.sequence.store(position + mask_ + 1, std::memory_order_release);
+            dequeue_position_.store(++position, std::memory_order_release);
+            any = true;
+        }
+
+        if (const auto dropped = dropped_.load(std::memory_order_relaxed); dropped != reported_dropped_) {
+            const auto text = fmt::format("{0} log message(s) dropped, the log ring was full!",
+                                          dropped - reported_dropped_);
+            reported_dropped_ = dropped;
+
+            target_->log(spdlog::details::log_msg("log", spdlog::level::warn, text));
+        }
+
+        return any;
+    }
+}  // namespace logging
@@ -0,0 +1,133 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/details/log_msg.h>
+#include <spdlog/sinks/sink.h>
+
+namespace logging {
+    enum class overflow_policy : std::uint8_t {
+        // a message that finds the ring full is dropped and counted, so that logging never stalls the caller
+        drop,
+        // the caller waits for the writer thread to make room
+        block,
+    };
+
+    /**
+     * @brief Sink that hands messages to a writer thread through a bounded lock-free ring, so that the threads
+     * logging never wait on the terminal or a file.
+     * @note Messages are copied into fixed-size slots and truncated to fit; formatting and writing happen on the
+     * writer thread, through the target sink.
+     */
+    struct async_ring_sink final : spdlog::sinks::sink {
+        // bytes of message text a slot holds
+        constexpr static std::size_t MAX_MESSAGE_LENGTH = 480;
+        constexpr static std::size_t MAX_LOGGER_NAME_LENGTH = 15;
+
+        /**
+         * @brief Constructor; starts the writer thread.
+         * @param target The sink the writer thread writes to.
+         * @param capacity Number of slots in the ring; rounded up to a power of two.
+         * @param overflow What to do with messages that find the ring full.
+         */
+        async_ring_sink(std::shared_ptr<spdlog::sinks::sink> target, std::size_t capacity, overflow_policy overflow);
+
+        /**
+         * @brief Destructor; writes out every queued message and stops the writer thread.
+         */
+        ~async_ring_sink() override;
+
+        async_ring_sink(const async_ring_sink &) = delete;
+        async_ring_sink &operator=(const async_ring_sink &) = delete;
+
+        void log(const spdlog::details::log_msg &msg) override;
+
+        /**
+         * @brief Waits for every message queued so far to be written, then flushes the target.
+         */
+        void flush() override;
+
+        void set_pattern(const std::string &pattern) override;
+        void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override;
+
+        /**
+         * @brief Gets the number of messages dropped because the ring was full.
+         * @return The number of dropped messages.
+         */
+        std::uint64_t dropped() const {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct slot {
+            // the position the slot is free for, or one past the position it holds a message of
+            std::atomic<std::uint64_t> sequence;
+
+            spdlog::log_clock::time_point time;
+            std::size_t thread_id;
+            spdlog::level::level_enum level;
+            std::uint8_t logger_name_length;
+            std::uint16_t length;
+            char logger_name[MAX_LOGGER_NAME_LENGTH];
+            char text[MAX_MESSAGE_LENGTH];
+        };
+
+        /**
+         * @brief Takes messages out of the ring and writes them, until the sink is destroyed.
+         */
+        void run();
+
+        /**
+         * @brief Writes every message in the ring.
+         * @return true if there was any, false otherwise.
+         */
+        bool drain();
+
+        std::shared_ptr<spdlog::sinks::sink> target_;
+        overflow_policy overflow_;
+
+        std::unique_ptr<slot[]> slots_;
+        std::uint64_t mask_;
+
+        alignas(64) std::atomic<std::uint64_t> enqueue_position_{0};
+        alignas(64) std::atomic<std::uint64_t> dequeue_position_{0};
+        std::atomic<std::uint64_t> dropped_{0};
+        std::uint64_t reported_dropped_ = 0;
+
+        // the writer thread sleeps on wakeups_ when the ring is empty, and says so through sleeping_
+        std::atomic<std::uint32_t> wakeups_{0};
+        std::atomic<bool> sleeping_{false};
+        std::atomic<bool> stopping_{false};
+
+        std::thread writer_;
+    };
+}  // namespace logging
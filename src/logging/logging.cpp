@@ -0,0 +1,90 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <logging/logging.h>
+
+#include <algorithm>
+#include <memory>
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+namespace logging {
+    namespace {
+        constexpr std::array<std::string_view, std::size_t(subsystem::count)> NAMES{"system", "net", "server"};
+
+        std::shared_ptr<async_ring_sink> ring;
+
+        bool parse_level(std::string_view text, spdlog::level::level_enum &level) {
+            level = spdlog::level::from_str(std::string(text));
+
+            // from_str gives off for anything it doesn't know
+            return level != spdlog::level::off || text == "off";
+        }
+    }
+
+    bool parse_levels(std::string_view spec, settings &s) {
+        while (!spec.empty()) {
+            const auto comma = spec.find(',');
+            const auto item = spec.substr(0, comma);
+            spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+
+            const auto equals = item.find('=');
+            if (equals == std::string_view::npos) {
+                spdlog::level::level_enum level;
+                if (!parse_level(item, level)) {
+                    return false;
+                }
+
+                s.levels.fill(level);
+                continue;
+            }
+
+            const auto name = item.substr(0, equals);
+            const auto it = std::find(NAMES.begin(), NAMES.end(), name);
+            if (it == NAMES.end() || !parse_level(item.substr(equals + 1), s.levels[it - NAMES.begin()])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void init(const settings &s) {
+        ring = std::make_shared<async_ring_sink>(std::make_shared<spdlog::sinks::stdout_color_sink_mt>(),
+                                                 s.queue_capacity, s.overflow);
+
+        for (std::size_t i = 0; i < NAMES.size(); i++) {
+            auto logger = std::make_shared<spdlog::logger>(std::string(NAMES[i]), ring);
+            logger->set_level(s.levels[i]);
+
+            spdlog::register_logger(logger);
+            impl::loggers[i] = logger.get();
+        }
+    }
+
+    void shutdown() {
+        impl::loggers.fill(nullptr);
+
+        spdlog::drop_all();
+        ring.reset();
+    }
+}  // namespace logging
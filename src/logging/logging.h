@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include <logging/async_ring_sink.h>
+
+#include <spdlog/spdlog.h>
+
+namespace logging {
+    enum class subsystem : std::uint8_t {
+        system,
+        net,
+        server,
+        count,
+    };
+
+    struct settings {
+        // runtime level of every subsystem; call sites below SPDLOG_ACTIVE_LEVEL are compiled out regardless
+        std::array<spdlog::level::level_enum, std::size_t(subsystem::count)> levels{
+                spdlog::level::info, spdlog::level::info, spdlog::level::info};
+
+        overflow_policy overflow = overflow_policy::drop;
+
+        // messages the ring holds before the overflow policy kicks in
+        std::size_t queue_capacity = 8192;
+    };
+
+    namespace impl {
+        inline std::array<spdlog::logger *, std::size_t(subsystem::count)> loggers{};
+    }
+
+    /**
+     * @brief Parses per-subsystem levels, such as "info" or "net=debug,server=trace".
+     * @param spec The levels; a bare level applies to every subsystem.
+     * @param s The settings to store the levels in.
+     * @return true if the levels were parsed, false otherwise.
+     */
+    bool parse_levels(std::string_view spec, settings &s);
+
+    /**
+     * @brief Creates the loggers of every subsystem, writing to the terminal through an asynchronous ring.
+     * @param s The settings.
+     */
+    void init(const settings &s);
+
+    /**
+     * @brief Writes out every queued message and releases the loggers.
+     */
+    void shutdown();
+
+    /**
+     * @brief Gets the logger of a subsystem without going through the locked spdlog registry.
+     * @param which The subsystem.
+     * @return The logger; the default spdlog logger before init().
+     */
+    inline spdlog::logger *get(subsystem which) {
+        auto *logger = impl::loggers[std::size_t(which)];
+        return logger != nullptr ? logger : spdlog::default_logger_raw();
+    }
+
+    inline spdlog::logger *system() {
+        return get(subsystem::system);
+    }
+
+    inline spdlog::logger *net() {
+        return get(subsystem::net);
+    }
+
+    inline spdlog::logger *server() {
+        return get(subsystem::server);
+    }
+}  // namespace logging
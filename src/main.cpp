@@ -20,111 +20,275 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
+#include <csignal>
 #include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include <spdlog/spdlog.h>
-#include <spdlog/sinks/stdout_color_sinks.h>
+#ifdef __linux__
 
-#include <server/server.h>
+#include <pthread.h>
+#include <sched.h>
 
-void init_loggers() {
-    spdlog::stdout_color_st("system");
-    spdlog::stdout_color_st("net");
-    spdlog::stdout_color_st("server");
+#endif
 
-    spdlog::get("system")->set_level(spdlog::level::trace);
-    spdlog::get("net")->set_level(spdlog::level::trace);
-    spdlog::get("server")->set_level(spdlog::level::trace);
-}
+#include <capture/recorder.h>
+#include <capture/trace.h>
 
-int32_t main() {
-    init_loggers();
-    net::impl::impl_init();
+#include <logging/logging.h>
+
+#include <metrics/exporter.h>
+
+#include <server/config.h>
+#include <server/event_loop.h>
+#include <server/relay.h>
+#include <server/router.h>
+#include <server/session_table.h>
+
+namespace {
+    std::vector<std::unique_ptr<server::event_loop>> *running_loops = nullptr;
+    metrics::exporter *running_exporter = nullptr;
 
-    spdlog::get("system")->info("Welcome to the YMRedux Server!");
-    spdlog::get("system")->info("Initializing YMSG Server...");
+#ifdef __linux__
+    server::relay *running_relay = nullptr;
+#endif
+
+    void on_terminate(int) {
+        if (running_loops != nullptr) {
+            for (auto &loop: *running_loops) {
+                loop->stop();
+            }
+        }
+
+        if (running_exporter != nullptr) {
+            running_exporter->stop();
+        }
 
-    net::socket ymsg_sock(net::socket::type::stream);
-    if (!ymsg_sock.bind(net::endpoint("127.0.0.1", 5050))) {
-        spdlog::get("system")->error("Failed to bind!");
+#ifdef __linux__
+        if (running_relay != nullptr) {
+            running_relay->stop();
+        }
+#endif
+    }
+
+#ifdef SIGUSR1
+    void on_dump_request(int) {
+        if (running_loops != nullptr) {
+            for (auto &loop: *running_loops) {
+                loop->request_dump();
+            }
+        }
+    }
+#endif
+
+    void pin_current_thread(std::size_t index) {
+#ifdef __linux__
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % std::thread::hardware_concurrency(), &cpus);
+
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+            logging::system()->warn("Failed to pin thread {0} to a CPU!", index);
+        }
+#endif
+    }
+
+    std::optional<net::socket> open_listener(const std::string &address, std::uint16_t port, bool share_port) {
+        net::socket ymsg_sock(net::socket::type::stream);
+        ymsg_sock.set_reuse_address();
+
+        // every shard binds its own socket to the same port, and the kernel spreads incoming connections over them
+        if (share_port && !ymsg_sock.set_reuse_port()) {
+            logging::system()->error("Failed to enable port sharing!");
+            return std::nullopt;
+        }
+
+        if (!ymsg_sock.bind(net::endpoint(address, port))) {
+            logging::system()->error("Failed to bind!");
+            return std::nullopt;
+        }
+
+        if (!ymsg_sock.listen()) {
+            logging::system()->error("Failed to listen for connections!");
+            return std::nullopt;
+        }
+
+        return ymsg_sock;
+    }
+}
+
+int32_t main(int32_t argc, char **argv) {
+    const auto options = server::parse_arguments(argc, argv);
+    if (!options.has_value()) {
         return EXIT_FAILURE;
     }
 
-    if (!ymsg_sock.listen()) {
-        spdlog::get("system")->error("Failed to listen for connections!");
+    logging::init(options->log);
+    net::impl::impl_init();
+
+    logging::system()->info("Welcome to the YMRedux Server!");
+    logging::system()->info("Initializing YMSG Server...");
+
+    // both outlive the loops, whose connections remove their sessions from the table as they are closed
+    server::session_table sessions(options->threads);
+    server::message_router router(options->threads);
+
+    if (!router.is_valid()) {
+        logging::system()->error("Failed to create the mailboxes of the event loops!");
         return EXIT_FAILURE;
     }
 
-    spdlog::get("system")->info("YMSG Server is listening for connections!");
+    std::vector<std::unique_ptr<server::event_loop>> loops;
 
-    while (1) {
-        auto client = ymsg_sock.accept();
+    for (std::uint32_t shard = 0; shard < options->threads; shard++) {
+        auto ymsg_sock = open_listener(options->address, options->port, options->threads > 1);
+        if (!ymsg_sock.has_value()) {
+            return EXIT_FAILURE;
+        }
 
-        if (!client.has_value()) {
-            continue;
+        auto loop = server::event_loop::create(options->backend, shard, sessions, router, std::move(*ymsg_sock));
+        if (loop == nullptr) {
+            logging::system()->error("The selected I/O backend is not available on this system!");
+            return EXIT_FAILURE;
         }
 
-        auto &[socket, _] = client.value();
+        loop->set_dev_login(options->dev_login);
 
-        spdlog::get("net")->info("New connection received!");
+        if (!options->capture_path.empty()) {
+            auto recorder = capture::recorder::open(options->capture_path, shard);
+            if (recorder == nullptr) {
+                return EXIT_FAILURE;
+            }
 
-        std::vector<std::byte> buffer;
+            loop->set_recorder(std::move(recorder));
+        }
 
-        while (socket.is_valid()) {
-            if (!socket.read(buffer)) {
-                spdlog::get("net")->critical("Read error!");
-                socket.close();
-                continue;
+        if (!options->trace_path.empty()) {
+            auto tracer = capture::tracer::open(options->trace_path, shard);
+            if (tracer == nullptr) {
+                return EXIT_FAILURE;
             }
 
-            net::deserializer frame(buffer);
+            loop->set_tracer(std::move(tracer));
+        }
 
-            while (frame.size() >= sizeof(net::protocol::ymsg_frame_header)) {
-                net::protocol::ymsg_header header;
-                header.deserialize(frame);
+        loops.push_back(std::move(loop));
+    }
 
-                if (header.magic != net::protocol::YMSG_HEADER_MAGIC) {
-                    spdlog::get("net")->critical("Invalid packet magic!");
+    logging::system()->info("YMSG Server is listening for connections on {0} thread(s)!", loops.size());
 
-                    socket.close();
-                    break;
-                }
+    if (!options->capture_path.empty()) {
+        logging::system()->warn("Recording every frame to {0}.*!", options->capture_path);
+    }
 
-                if (frame.size() >= header.length) {
-                    // read all fields in frame
-                    std::vector<net::protocol::ymsg_field> fields;
+    if (options->dev_login) {
+        logging::system()->warn("Every login is accepted without checking credentials!");
+    }
 
-                    while (frame.size() > 0) {
-                        fields.emplace_back(frame);
-                    }
+    if (!options->trace_path.empty()) {
+        logging::system()->warn("Tracing every frame to {0}.*!", options->trace_path);
+    }
 
-                    server::handle_frame(socket, header, fields);
-                }
-            }
+#ifdef __linux__
+    std::unique_ptr<server::relay> relay;
 
-            // we have read everything in our buffer
-            if (frame.size() == 0 && buffer.size()) {
-                buffer.clear();
-            }
-//            net::serializer p_data;
-//            net::protocol::ymsg_field field(net::protocol::YMSG_FLD_CURRENT_ID, "cox");
-//            p_data.emplace<net::protocol::ymsg_field>(field);
-//
-//            net::serializer s;
-//            s.emplace<net::protocol::ymsg_header>(16,
-//                                                  0,
-//                                                  p_data.size(),
-//                                                  net::protocol::YES_USER_LOGIN,
-//                                                  net::protocol::YES_STATUS_NOTIFY,
-//                                                  0);
-//            s.serialize(p_data.data().data(), p_data.size());
-//
-//            socket.write(s);
+    if (options->relay_port != 0) {
+        auto relay_sock = open_listener(options->address, options->relay_port, false);
+        if (!relay_sock.has_value()) {
+            return EXIT_FAILURE;
         }
 
-        spdlog::get("net")->error("Connection lost!");
+        relay = std::make_unique<server::relay>(std::move(*relay_sock), options->spool_directory);
+        logging::system()->info("File transfer relay is listening on port {0}!", options->relay_port);
     }
+#else
+    if (options->relay_port != 0) {
+        logging::system()->warn("The file transfer relay is only available on Linux!");
+    }
+#endif
+
+    std::unique_ptr<metrics::exporter> exporter;
+
+    if (options->metrics_port != 0) {
+        auto metrics_sock = open_listener(options->metrics_address, options->metrics_port, false);
+        if (!metrics_sock.has_value()) {
+            return EXIT_FAILURE;
+        }
+
+        exporter = std::make_unique<metrics::exporter>(std::move(*metrics_sock));
+        logging::system()->info("Metrics are served on http://{0}:{1}/metrics!", options->metrics_address,
+                                options->metrics_port);
+    }
+
+    running_loops = &loops;
+    std::signal(SIGINT, on_terminate);
+    std::signal(SIGTERM, on_terminate);
+
+#ifdef SIGUSR1
+    // logs the last frames of every connection, for looking into a misbehaving client without restarting
+    std::signal(SIGUSR1, on_dump_request);
+#endif
+
+    std::vector<std::thread> threads;
+    std::vector<char> clean_exits(loops.size(), false);
+
+#ifdef __linux__
+    // bulk file data stays off the threads parsing frames
+    auto relay_clean_exit = true;
+
+    if (relay != nullptr) {
+        running_relay = relay.get();
+
+        threads.emplace_back([&] {
+            relay_clean_exit = relay->run();
+            on_terminate(0);
+        });
+    }
+#endif
+
+    auto exporter_clean_exit = true;
+
+    if (exporter != nullptr) {
+        running_exporter = exporter.get();
+
+        threads.emplace_back([&] {
+            exporter_clean_exit = exporter->run();
+            on_terminate(0);
+        });
+    }
+
+    for (std::size_t shard = 0; shard < loops.size(); shard++) {
+        threads.emplace_back([&, shard] {
+            if (options->pin_threads) {
+                pin_current_thread(shard);
+            }
+
+            clean_exits[shard] = loops[shard]->run();
+
+            // one shard going down takes the whole server with it
+            on_terminate(0);
+        });
+    }
+
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    running_loops = nullptr;
+    running_exporter = nullptr;
+    logging::system()->info("YMSG Server stopped.");
+
+    auto clean_exit = exporter_clean_exit && std::ranges::all_of(clean_exits, [](char clean) { return clean != 0; });
+
+#ifdef __linux__
+    running_relay = nullptr;
+    clean_exit = clean_exit && relay_clean_exit;
+#endif
 
     net::impl::impl_cleanup();
-    return EXIT_SUCCESS;
+    logging::shutdown();
+    return clean_exit ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,224 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <metrics/exporter.h>
+#include <metrics/metrics.h>
+
+#include <array>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include <logging/logging.h>
+
+namespace metrics {
+    namespace {
+        constexpr std::int32_t POLL_TIMEOUT_MS = 100;
+
+        // scrapers that haven't sent a request, or read the response, by then are dropped
+        constexpr std::chrono::seconds SCRAPE_TIMEOUT{5};
+
+        constexpr std::size_t MAX_REQUEST_HEAD = 4096;
+
+        std::string make_response(std::string_view status, std::string_view body) {
+            return fmt::format("HTTP/1.1 {0}\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                               "Content-Length: {1}\r\nConnection: close\r\n\r\n{2}",
+                               status, body.size(), body);
+        }
+    }  // namespace
+
+    exporter::exporter(net::socket listener) : listener_(std::move(listener)) {}
+
+    bool exporter::run() {
+        if (!poller_.is_valid() || !listener_.set_non_blocking()) {
+            logging::net()->error("Failed to set up the metrics exporter!");
+            return false;
+        }
+
+        if (!poller_.add(listener_.get(), net::poller::readable, nullptr)) {
+            logging::net()->error("Failed to watch the metrics socket!");
+            return false;
+        }
+
+        std::array<net::poller::event, 64> events{};
+        running_ = true;
+
+        while (running_) {
+            const auto count = poller_.wait(events, POLL_TIMEOUT_MS);
+            if (count < 0) {
+                if (net::impl::interrupted()) {
+                    continue;
+                }
+
+                logging::net()->critical("Polling failed!");
+                return false;
+            }
+
+            for (std::int32_t i = 0; i < count; i++) {
+                const auto &event = events[i];
+
+                if (event.data == nullptr) {
+                    accept_scrapers();
+                    continue;
+                }
+
+                auto &s = *static_cast<scraper *>(event.data);
+                if (s.closed) {
+                    continue;
+                }
+
+                if (event.events & net::poller::error) {
+                    close_scraper(s);
+                    continue;
+                }
+
+                on_event(s);
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            std::erase_if(scrapers_, [&](const auto &entry) {
+                if (now - entry.second->accepted < SCRAPE_TIMEOUT) {
+                    return false;
+                }
+
+                poller_.remove(entry.first);
+                return true;
+            });
+
+            closed_scrapers_.clear();
+        }
+
+        return true;
+    }
+
+    void exporter::accept_scrapers() {
+        std::optional<std::pair<net::socket, net::endpoint>> client;
+        net::socket::accept_status status;
+
+        while ((status = listener_.accept(client)) == net::socket::accept_status::accepted) {
+            auto &[socket, endpoint] = client.value();
+            const auto handle = socket.get();
+
+            if (!socket.set_non_blocking()) {
+                continue;
+            }
+
+            auto s = std::make_unique<scraper>(std::move(socket), std::chrono::steady_clock::now());
+
+            if (!poller_.add(handle, net::poller::readable | net::poller::writable, s.get())) {
+                logging::net()->error("Failed to watch metrics scraper {0}!", endpoint.to_string());
+                continue;
+            }
+
+            scrapers_.emplace(handle, std::move(s));
+        }
+
+        if (status == net::socket::accept_status::failed) {
+            logging::net()->error("Failed to accept metrics scrapers!");
+        }
+    }
+
+    void exporter::on_event(scraper &s) {
+        if (!s.response.empty()) {
+            if (write_response(s)) {
+                close_scraper(s);
+            }
+
+            return;
+        }
+
+        std::array<char, 1024> buffer{};
+
+        while (true) {
+            const auto bytes_read = s.socket.read_raw(buffer.data(), buffer.size());
+            if (bytes_read < 0 && net::impl::interrupted()) {
+                continue;
+            }
+
+            if (bytes_read < 0 && net::impl::would_block()) {
+                break;
+            }
+
+            if (bytes_read <= 0) {
+                close_scraper(s);
+                return;
+            }
+
+            s.request.append(buffer.data(), bytes_read);
+
+            // checked as it grows, so that a peer that keeps the socket full can't grow it without bound
+            if (s.request.size() > MAX_REQUEST_HEAD) {
+                close_scraper(s);
+                return;
+            }
+        }
+
+        const std::string_view request(s.request);
+        if (request.find("\r\n\r\n") == std::string_view::npos) {
+            return;
+        }
+
+        if (request.starts_with("GET /metrics ") || request.starts_with("GET /metrics?")) {
+            s.response = make_response("200 OK", render());
+        } else {
+            s.response = make_response("404 Not Found", "Not found.\n");
+        }
+
+        if (write_response(s)) {
+            close_scraper(s);
+        }
+    }
+
+    bool exporter::write_response(scraper &s) {
+        while (s.written < s.response.size()) {
+            const auto bytes_written =
+                    s.socket.write_raw(s.response.data() + s.written, s.response.size() - s.written);
+            if (bytes_written < 0 && net::impl::interrupted()) {
+                continue;
+            }
+
+            if (bytes_written < 0 && net::impl::would_block()) {
+                return false;
+            }
+
+            if (bytes_written <= 0) {
+                // the scraper went away; nothing left to do for it
+                return true;
+            }
+
+            s.written += bytes_written;
+        }
+
+        return true;
+    }
+
+    void exporter::close_scraper(scraper &s) {
+        s.closed = true;
+
+        const auto handle = s.socket.get();
+        poller_.remove(handle);
+
+        const auto it = scrapers_.find(handle);
+        closed_scrapers_.push_back(std::move(it->second));
+        scrapers_.erase(it);
+    }
+}  // namespace metrics
@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <net/poller.h>
+#include <net/socket.h>
+
+namespace metrics {
+    /**
+     * @brief Serves the metrics of every shard over HTTP, in the Prometheus text exposition format, on
+     * "GET /metrics".
+     * @note Runs on a thread of its own; scrapes read the shards without stopping the event loops.
+     */
+    struct exporter {
+        /**
+         * @brief Constructor.
+         * @param listener A bound, listening socket. The exporter switches it to non-blocking mode.
+         */
+        explicit exporter(net::socket listener);
+
+        exporter(const exporter &) = delete;
+        exporter &operator=(const exporter &) = delete;
+
+        /**
+         * @brief Serves scrapes until stop() is called.
+         * @return true if the exporter exited cleanly, false if it failed to start or to poll.
+         */
+        bool run();
+
+        /**
+         * @brief Asks the exporter to exit.
+         * @note Safe to call from any thread and from signal handlers.
+         */
+        void stop() {
+            running_ = false;
+        }
+
+    private:
+        struct scraper {
+            net::socket socket;
+            std::chrono::steady_clock::time_point accepted;
+
+            std::string request;
+            std::string response;
+            std::size_t written = 0;
+            bool closed = false;
+        };
+
+        void accept_scrapers();
+
+        void on_event(scraper &s);
+
+        /**
+         * @brief Writes as much of the response as the socket takes.
+         * @return true if the whole response was written, false otherwise.
+         */
+        bool write_response(scraper &s);
+
+        void close_scraper(scraper &s);
+
+        net::poller poller_;
+        net::socket listener_;
+        std::atomic<bool> running_{false};
+
+        std::unordered_map<net::socket_type, std::unique_ptr<scraper>> scrapers_;
+
+        // events of the current batch may still point at scrapers closed while handling it
+        std::vector<std::unique_ptr<scraper>> closed_scrapers_;
+    };
+}  // namespace metrics
@@ -0,0 +1,206 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace metrics {
+    /**
+     * @brief Counter written by one thread and read by any; increments are plain loads and stores, so they cost no
+     * more than on an ordinary integer.
+     */
+    struct counter {
+        void add(std::uint64_t n = 1) {
+            value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        std::uint64_t load() const {
+            return value_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<std::uint64_t> value_{0};
+    };
+
+    /**
+     * @brief Gauge written by one thread and read by any.
+     */
+    struct gauge {
+        void add(std::int64_t n) {
+            value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        void set(std::int64_t value) {
+            value_.store(value, std::memory_order_relaxed);
+        }
+
+        std::int64_t load() const {
+            return value_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<std::int64_t> value_{0};
+    };
+
+    /**
+     * @brief Log-linear histogram in the style of HdrHistogram: every power of two is split into SUB_BUCKETS
+     * linear buckets, so any recorded value is off by at most 1/SUB_BUCKETS of itself. Written by one thread and
+     * read by any.
+     */
+    struct histogram {
+        constexpr static std::size_t SUB_BUCKET_BITS = 4;
+        constexpr static std::size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+        // values up to 2^MAX_EXPONENT - 1 get buckets of their own; larger ones land in the last bucket
+        constexpr static std::size_t MAX_EXPONENT = 36;
+        constexpr static std::size_t BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        /**
+         * @brief Records a value.
+         * @param value The value.
+         */
+        void record(std::uint64_t value) {
+            auto &bucket = buckets_[bucket_of(value)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+            count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Gets the bucket a value is counted in.
+         * @param value The value.
+         * @return The bucket index.
+         */
+        static constexpr std::size_t bucket_of(std::uint64_t value) {
+            if (value < SUB_BUCKETS) {
+                return value;
+            }
+
+            const std::size_t exponent = std::bit_width(value) - 1;
+            if (exponent >= MAX_EXPONENT) {
+                return BUCKETS - 1;
+            }
+
+            const auto sub_bucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+            return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+        }
+
+        /**
+         * @brief Gets the largest value counted in a bucket.
+         * @param bucket The bucket index.
+         * @return The upper bound of the bucket, inclusive.
+         */
+        static constexpr std::uint64_t upper_bound(std::size_t bucket) {
+            if (bucket < SUB_BUCKETS) {
+                return bucket;
+            }
+
+            const auto exponent = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+            const auto sub_bucket = bucket % SUB_BUCKETS;
+            const auto width = std::uint64_t(1) << (exponent - SUB_BUCKET_BITS);
+
+            return (std::uint64_t(SUB_BUCKETS + sub_bucket) << (exponent - SUB_BUCKET_BITS)) + width - 1;
+        }
+
+        std::uint64_t bucket(std::size_t index) const {
+            return buckets_[index].load(std::memory_order_relaxed);
+        }
+
+        std::uint64_t count() const {
+            return count_.load(std::memory_order_relaxed);
+        }
+
+        std::uint64_t sum() const {
+            return sum_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::array<std::atomic<std::uint64_t>, BUCKETS> buckets_{};
+        std::atomic<std::uint64_t> count_{0};
+        std::atomic<std::uint64_t> sum_{0};
+    };
+
+    /**
+     * @brief Plain copy of one or more histograms, summed, for reading them out.
+     */
+    struct histogram_snapshot {
+        std::array<std::uint64_t, histogram::BUCKETS> buckets{};
+        std::uint64_t count = 0;
+        std::uint64_t sum = 0;
+
+        /**
+         * @brief Adds the current contents of a histogram.
+         * @param h The histogram.
+         */
+        void add(const histogram &h) {
+            for (std::size_t i = 0; i < histogram::BUCKETS; i++) {
+                buckets[i] += h.bucket(i);
+            }
+
+            count += h.count();
+            sum += h.sum();
+        }
+
+        /**
+         * @brief Gets the value below which a fraction of the recorded values lie.
+         * @param quantile The fraction, between 0 and 1.
+         * @return The upper bound of the bucket holding the value, or 0 if nothing was recorded.
+         */
+        std::uint64_t value_at(double quantile) const {
+            if (count == 0) {
+                return 0;
+            }
+
+            const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(quantile * count));
+
+            std::uint64_t cumulative = 0;
+            std::size_t bucket = 0;
+            while (bucket + 1 < histogram::BUCKETS && cumulative + buckets[bucket] < rank) {
+                cumulative += buckets[bucket++];
+            }
+
+            return histogram::upper_bound(bucket);
+        }
+
+        /**
+         * @brief Gets the number of values up to a bound, inclusive.
+         * @param bound The bound; exact when it is the last value of a bucket, such as one below a power of two.
+         * @return The number of values in the buckets entirely at or below the bound.
+         */
+        std::uint64_t count_up_to(std::uint64_t bound) const {
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i < histogram::BUCKETS && histogram::upper_bound(i) <= bound; i++) {
+                cumulative += buckets[i];
+            }
+
+            return cumulative;
+        }
+    };
+}  // namespace metrics
@@ -0,0 +1,244 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <metrics/metrics.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <spdlog/fmt/fmt.h>
+
+namespace metrics {
+    namespace {
+        // the exporter walks the shards under this lock; the loops only take it when they start and exit
+        std::mutex shards_lock;
+        std::vector<const shard *> shards;
+
+        // inclusive upper bounds of the exported latency buckets, in nanoseconds, as Prometheus' le is; one below
+        // powers of two, so that they are exactly the last value of a histogram bucket, from about a microsecond to
+        // about a second
+        constexpr std::array<std::uint64_t, 11> LATENCY_BOUNDS = {
+                (1ull << 10) - 1, (1ull << 12) - 1, (1ull << 14) - 1, (1ull << 16) - 1,
+                (1ull << 18) - 1, (1ull << 20) - 1, (1ull << 22) - 1, (1ull << 24) - 1,
+                (1ull << 26) - 1, (1ull << 28) - 1, (1ull << 30) - 1,
+        };
+
+        constexpr std::array<std::pair<double, std::string_view>, 3> QUANTILES = {{
+                {0.5, "0.5"},
+                {0.99, "0.99"},
+                {0.999, "0.999"},
+        }};
+
+        /**
+         * @brief One message type, summed over every shard.
+         */
+        struct type_totals {
+            // by status; statuses that didn't get a slot in some shard are keyed as std::nullopt
+            std::map<std::optional<std::int32_t>, std::uint64_t> frames;
+            std::map<std::optional<std::int32_t>, histogram_snapshot> latency;
+        };
+
+        double to_seconds(std::uint64_t nanoseconds) {
+            return static_cast<double>(nanoseconds) / 1e9;
+        }
+
+        std::string type_label(std::size_t slot) {
+            return slot + 1 == TYPE_SLOTS ? "other" : std::to_string(slot);
+        }
+
+        std::string status_label(const std::optional<std::int32_t> &status) {
+            return status ? std::to_string(*status) : "other";
+        }
+    }  // namespace
+
+    shard::shard() {
+        std::lock_guard lock(shards_lock);
+        shards.push_back(this);
+    }
+
+    shard::~shard() {
+        {
+            std::lock_guard lock(shards_lock);
+            std::erase(shards, this);
+        }
+
+        for (auto &stats: types_) {
+            delete stats.load(std::memory_order_relaxed);
+        }
+    }
+
+    void shard::frame_received(net::protocol::YES_ type, net::protocol::YES_STATUS_ status) {
+        auto &stats = stats_of(type);
+        stats.frames[status_slot(stats, status)].add();
+    }
+
+    std::size_t shard::status_slot(type_stats &stats, net::protocol::YES_STATUS_ status) {
+        const auto used = stats.statuses_used.load(std::memory_order_relaxed);
+
+        for (std::size_t i = 0; i < used; i++) {
+            if (stats.statuses[i].load(std::memory_order_relaxed) == status) {
+                return i;
+            }
+        }
+
+        if (used == STATUS_SLOTS) {
+            return STATUS_SLOTS;
+        }
+
+        // publish the status before the slot, so that readers never see the slot without it
+        stats.statuses[used].store(status, std::memory_order_relaxed);
+        stats.statuses_used.store(used + 1, std::memory_order_release);
+        return used;
+    }
+
+    type_stats &shard::stats_of(net::protocol::YES_ type) {
+        auto &slot = types_[std::min<std::size_t>(type, TYPE_SLOTS - 1)];
+
+        auto *stats = slot.load(std::memory_order_relaxed);
+        if (stats == nullptr) {
+            stats = new type_stats();
+            slot.store(stats, std::memory_order_release);
+        }
+
+        return *stats;
+    }
+
+    std::string render() {
+        std::map<std::size_t, type_totals> types;
+        std::int64_t connections = 0;
+        std::int64_t queued_bytes = 0;
+        std::int64_t mailbox_depth = 0;
+        std::uint64_t bytes_received = 0;
+        std::uint64_t bytes_sent = 0;
+
+        {
+            std::lock_guard lock(shards_lock);
+
+            for (const auto *s: shards) {
+                connections += s->connections.load();
+                queued_bytes += s->queued_bytes.load();
+                mailbox_depth += s->mailbox_depth.load();
+                bytes_received += s->bytes_received.load();
+                bytes_sent += s->bytes_sent.load();
+
+                for (std::size_t slot = 0; slot < TYPE_SLOTS; slot++) {
+                    const auto *stats = s->find(slot);
+                    if (stats == nullptr) {
+                        continue;
+                    }
+
+                    auto &totals = types[slot];
+                    const auto used = stats->statuses_used.load(std::memory_order_acquire);
+
+                    for (std::size_t i = 0; i < used; i++) {
+                        const auto status = stats->statuses[i].load(std::memory_order_relaxed);
+                        totals.frames[status] += stats->frames[i].load();
+                        totals.latency[status].add(stats->latency[i]);
+                    }
+
+                    if (const auto rest = stats->frames[STATUS_SLOTS].load(); rest != 0) {
+                        totals.frames[std::nullopt] += rest;
+                        totals.latency[std::nullopt].add(stats->latency[STATUS_SLOTS]);
+                    }
+                }
+            }
+        }
+
+        fmt::memory_buffer out;
+        auto it = std::back_inserter(out);
+
+        fmt::format_to(it, "# HELP ymredux_connections Open client connections.\n"
+                           "# TYPE ymredux_connections gauge\n"
+                           "ymredux_connections {0}\n", connections);
+        fmt::format_to(it, "# HELP ymredux_outbound_queued_bytes Bytes waiting in outbound queues.\n"
+                           "# TYPE ymredux_outbound_queued_bytes gauge\n"
+                           "ymredux_outbound_queued_bytes {0}\n", queued_bytes);
+        fmt::format_to(it, "# HELP ymredux_mailbox_depth Messages from other threads waiting in the mailboxes of the "
+                           "event loops, as of their last drain.\n"
+                           "# TYPE ymredux_mailbox_depth gauge\n"
+                           "ymredux_mailbox_depth {0}\n", mailbox_depth);
+        fmt::format_to(it, "# HELP ymredux_received_bytes_total Bytes received from clients.\n"
+                           "# TYPE ymredux_received_bytes_total counter\n"
+                           "ymredux_received_bytes_total {0}\n", bytes_received);
+        fmt::format_to(it, "# HELP ymredux_sent_bytes_total Bytes sent to clients.\n"
+                           "# TYPE ymredux_sent_bytes_total counter\n"
+                           "ymredux_sent_bytes_total {0}\n", bytes_sent);
+
+        fmt::format_to(it, "# HELP ymredux_frames_received_total Frames received from clients.\n"
+                           "# TYPE ymredux_frames_received_total counter\n");
+        for (const auto &[slot, totals]: types) {
+            for (const auto &[status, count]: totals.frames) {
+                fmt::format_to(it, "ymredux_frames_received_total{{type=\"{0}\",status=\"{1}\"}} {2}\n",
+                               type_label(slot), status_label(status), count);
+            }
+        }
+
+        fmt::format_to(it, "# HELP ymredux_handler_latency_seconds Time spent in frame handlers.\n"
+                           "# TYPE ymredux_handler_latency_seconds histogram\n");
+        for (const auto &[slot, totals]: types) {
+            for (const auto &[status, latency]: totals.latency) {
+                if (latency.count == 0) {
+                    continue;
+                }
+
+                const auto labels = fmt::format("type=\"{0}\",status=\"{1}\"", type_label(slot), status_label(status));
+
+                for (const auto bound: LATENCY_BOUNDS) {
+                    fmt::format_to(it, "ymredux_handler_latency_seconds_bucket{{{0},le=\"{1}\"}} {2}\n", labels,
+                                   to_seconds(bound), latency.count_up_to(bound));
+                }
+
+                fmt::format_to(it, "ymredux_handler_latency_seconds_bucket{{{0},le=\"+Inf\"}} {1}\n", labels,
+                               latency.count);
+                fmt::format_to(it, "ymredux_handler_latency_seconds_sum{{{0}}} {1}\n", labels, to_seconds(latency.sum));
+                fmt::format_to(it, "ymredux_handler_latency_seconds_count{{{0}}} {1}\n", labels, latency.count);
+            }
+        }
+
+        fmt::format_to(it, "# HELP ymredux_handler_latency_quantile_seconds Quantiles of the time spent in frame "
+                           "handlers, exact to 1/16 of the value.\n"
+                           "# TYPE ymredux_handler_latency_quantile_seconds gauge\n");
+        for (const auto &[slot, totals]: types) {
+            for (const auto &[status, latency]: totals.latency) {
+                if (latency.count == 0) {
+                    continue;
+                }
+
+                for (const auto &[quantile, label]: QUANTILES) {
+                    fmt::format_to(it,
+                                   "ymredux_handler_latency_quantile_seconds{{type=\"{0}\",status=\"{1}\","
+                                   "quantile=\"{2}\"}} {3}\n",
+                                   type_label(slot), status_label(status), label,
+                                   to_seconds(latency.value_at(quantile)));
+                }
+            }
+        }
+
+        return fmt::to_string(out);
+    }
+}  // namespace metrics
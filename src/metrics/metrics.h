@@ -0,0 +1,144 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <metrics/histogram.h>
+
+#include <net/protocol/ymsg/enums/ymsg_message_type.hpp>
+#include <net/protocol/ymsg/enums/ymsg_status_type.hpp>
+
+namespace metrics {
+    // one slot per message type, plus one for types the protocol doesn't define
+    constexpr std::size_t TYPE_SLOTS = net::protocol::YES_LWMOPI_STOPOPI + 2;
+
+    // distinct statuses counted per message type; any further ones are counted together
+    constexpr std::size_t STATUS_SLOTS = 8;
+
+    /**
+     * @brief What one shard observed of one message type.
+     */
+    struct type_stats {
+        // statuses seen so far, in the order they were first seen; slots past `statuses_used` are unset
+        std::array<std::atomic<std::int32_t>, STATUS_SLOTS> statuses{};
+        std::atomic<std::size_t> statuses_used{0};
+
+        // frames per status slot, and then frames of any status that didn't get a slot
+        std::array<counter, STATUS_SLOTS + 1> frames;
+
+        // time spent in the handler, in nanoseconds, by the same status slots
+        std::array<histogram, STATUS_SLOTS + 1> latency;
+    };
+
+    /**
+     * @brief Metrics of one event loop thread. Only the owning thread writes to a shard, so recording costs a few
+     * relaxed stores and never a lock or a contended cache line; the exporter reads every shard when it is scraped.
+     * @note The metrics of a shard disappear with it.
+     */
+    struct shard {
+        /**
+         * @brief Constructor; makes the shard visible to render().
+         */
+        shard();
+
+        /**
+         * @brief Destructor; hides the shard from render().
+         */
+        ~shard();
+
+        shard(const shard &) = delete;
+        shard &operator=(const shard &) = delete;
+
+        /**
+         * @brief Counts a frame received from a client.
+         * @param type The message type of the frame.
+         * @param status The status of the frame.
+         */
+        void frame_received(net::protocol::YES_ type, net::protocol::YES_STATUS_ status);
+
+        /**
+         * @brief Records the time a handler took.
+         * @param type The message type of the handled frame.
+         * @param status The status of the handled frame.
+         * @param elapsed The time the handler took.
+         */
+        void frame_handled(net::protocol::YES_ type, net::protocol::YES_STATUS_ status,
+                           std::chrono::nanoseconds elapsed) {
+            auto &stats = stats_of(type);
+            stats.latency[status_slot(stats, status)].record(elapsed.count() < 0 ? 0 : elapsed.count());
+        }
+
+        /**
+         * @brief Gets what the shard observed of a message type.
+         * @param slot The type slot.
+         * @return The statistics, or nullptr if no frame of the type was seen yet.
+         */
+        const type_stats *find(std::size_t slot) const {
+            return types_[slot].load(std::memory_order_acquire);
+        }
+
+        // open client connections
+        gauge connections;
+
+        // bytes waiting in outbound queues
+        gauge queued_bytes;
+
+        // messages from other loops waiting in the mailbox, as of the last time it was drained
+        gauge mailbox_depth;
+
+        counter bytes_received;
+        counter bytes_sent;
+
+    private:
+        /**
+         * @brief Gets the statistics of a message type, allocating them the first time the type is seen.
+         * @param type The message type.
+         * @return The statistics.
+         */
+        type_stats &stats_of(net::protocol::YES_ type);
+
+        /**
+         * @brief Gets the slot of a status, giving it the next free one the first time it is seen.
+         * @param stats The statistics of the message type.
+         * @param status The status.
+         * @return The slot, or STATUS_SLOTS if every slot is taken by other statuses.
+         */
+        static std::size_t status_slot(type_stats &stats, net::protocol::YES_STATUS_ status);
+
+        // allocated lazily, since a shard only ever sees a handful of the types
+        std::array<std::atomic<type_stats *>, TYPE_SLOTS> types_{};
+    };
+
+    /**
+     * @brief Renders the metrics of every live shard in the Prometheus text exposition format.
+     * @return The metrics.
+     */
+    std::string render();
+}  // namespace metrics
@@ -0,0 +1,176 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <new>
+
+namespace net {
+    /**
+     * @brief Thread-local cache of heap blocks in power-of-two size classes, so that buffers which live for a single
+     * frame are recycled instead of going back to the allocator.
+     * @note A block may be released on a thread other than the one that acquired it; it then joins the releasing
+     * thread's cache. Sizes past the largest class are not cached.
+     */
+    struct buffer_pool {
+        // smallest class: 64 bytes, largest: 64 KiB
+        constexpr static std::size_t MIN_CLASS_SHIFT = 6;
+        constexpr static std::size_t MAX_CLASS_SHIFT = 16;
+        constexpr static std::size_t CLASS_COUNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+
+        // idle bytes kept per class and thread, but never fewer blocks than the minimum
+        constexpr static std::size_t CACHED_BYTES_PER_CLASS = 262144;
+        constexpr static std::size_t MIN_CACHED_BLOCKS = 8;
+
+        /**
+         * @brief Gets the size of the block that serves a request.
+         * @param size The requested size.
+         * @return The size of the size class that fits size, or size itself if it's past the largest class.
+         */
+        static constexpr std::size_t block_size(std::size_t size) {
+            if (size > (std::size_t(1) << MAX_CLASS_SHIFT)) {
+                return size;
+            }
+
+            return std::max(std::size_t(1) << MIN_CLASS_SHIFT, std::bit_ceil(size));
+        }
+
+        /**
+         * @brief Acquires a block.
+         * @param size The requested size.
+         * @return A block of block_size(size) bytes.
+         */
+        static void *acquire(std::size_t size) {
+            size = block_size(size);
+
+            if (size <= (std::size_t(1) << MAX_CLASS_SHIFT) && !cache_destroyed_) {
+                auto &list = cache().lists[class_of(size)];
+
+                if (list.head != nullptr) {
+                    auto *block = list.head;
+                    list.head = block->next;
+                    list.count--;
+                    return block;
+                }
+            }
+
+            return ::operator new(size);
+        }
+
+        /**
+         * @brief Releases a block.
+         * @param block The block, as returned by acquire().
+         * @param size The size the block was acquired with, or its block_size().
+         */
+        static void release(void *block, std::size_t size) {
+            if (block == nullptr) {
+                return;
+            }
+
+            size = block_size(size);
+
+            if (size <= (std::size_t(1) << MAX_CLASS_SHIFT) && !cache_destroyed_) {
+                auto &list = cache().lists[class_of(size)];
+
+                if (list.count < std::max(MIN_CACHED_BLOCKS, CACHED_BYTES_PER_CLASS / size)) {
+                    list.head = ::new(block) free_block{list.head};
+                    list.count++;
+                    return;
+                }
+            }
+
+            ::operator delete(block, size);
+        }
+
+    private:
+        struct free_block {
+            free_block *next;
+        };
+
+        struct free_list {
+            free_block *head = nullptr;
+            std::size_t count = 0;
+        };
+
+        struct thread_cache {
+            std::array<free_list, CLASS_COUNT> lists{};
+
+            ~thread_cache() {
+                // blocks released by thread_local destructors running after this one bypass the cache
+                cache_destroyed_ = true;
+
+                for (std::size_t i = 0; i < CLASS_COUNT; i++) {
+                    while (lists[i].head != nullptr) {
+                        auto *block = lists[i].head;
+                        lists[i].head = block->next;
+                        ::operator delete(block, std::size_t(1) << (i + MIN_CLASS_SHIFT));
+                    }
+                }
+            }
+        };
+
+        static std::size_t class_of(std::size_t size) {
+            return std::countr_zero(size) - MIN_CLASS_SHIFT;
+        }
+
+        static thread_cache &cache() {
+            thread_local thread_cache cache;
+            return cache;
+        }
+
+        static inline thread_local bool cache_destroyed_ = false;
+    };
+
+    /**
+     * @brief Standard allocator drawing from the buffer pool, for containers that churn through short-lived nodes.
+     * @tparam T The type of the objects to allocate.
+     */
+    template<typename T>
+    struct pool_allocator {
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "pooled blocks only have the default alignment");
+
+        using value_type = T;
+
+        pool_allocator() noexcept = default;
+
+        template<typename U>
+        pool_allocator(const pool_allocator<U> &) noexcept {}
+
+        T *allocate(std::size_t n) {
+            return static_cast<T *>(buffer_pool::acquire(n * sizeof(T)));
+        }
+
+        void deallocate(T *p, std::size_t n) noexcept {
+            buffer_pool::release(p, n * sizeof(T));
+        }
+
+        template<typename U>
+        bool operator==(const pool_allocator<U> &) const noexcept {
+            return true;
+        }
+    };
+}  // namespace net
@@ -0,0 +1,134 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define NET_SCAN_X86 1
+#endif
+
+namespace net {
+    namespace impl {
+        using find_pair_function = std::size_t (*)(const std::byte *, std::size_t, std::byte, std::byte);
+
+        inline std::size_t find_pair_scalar(const std::byte *data, std::size_t len, std::byte lead, std::byte follow) {
+            for (std::size_t i = 0; i + 1 < len; i++) {
+                const auto *candidate = static_cast<const std::byte *>(std::memchr(data + i, int(lead), len - i - 1));
+                if (candidate == nullptr) {
+                    break;
+                }
+
+                i = candidate - data;
+                if (data[i + 1] == follow) {
+                    return i;
+                }
+            }
+
+            return static_cast<std::size_t>(-1);
+        }
+
+#ifdef NET_SCAN_X86
+        // compares every position against the lead byte and the position after it against the follow-up byte, so a
+        // block covers 16 candidates but reads 17 bytes
+        inline std::size_t find_pair_sse2(const std::byte *data, std::size_t len, std::byte lead, std::byte follow) {
+            const auto leads = _mm_set1_epi8(static_cast<char>(lead));
+            const auto follows = _mm_set1_epi8(static_cast<char>(follow));
+
+            std::size_t i = 0;
+            for (; i + 17 <= len; i += 16) {
+                const auto first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+                const auto second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 1));
+                const auto hits = _mm_and_si128(_mm_cmpeq_epi8(first, leads), _mm_cmpeq_epi8(second, follows));
+
+                if (const auto mask = static_cast<unsigned>(_mm_movemask_epi8(hits)); mask != 0) {
+                    return i + std::countr_zero(mask);
+                }
+            }
+
+            const auto rest = find_pair_scalar(data + i, len - i, lead, follow);
+            return rest == static_cast<std::size_t>(-1) ? rest : i + rest;
+        }
+
+#ifdef __GNUC__
+        [[gnu::target("avx2")]]
+        inline std::size_t find_pair_avx2(const std::byte *data, std::size_t len, std::byte lead, std::byte follow) {
+            const auto leads = _mm256_set1_epi8(static_cast<char>(lead));
+            const auto follows = _mm256_set1_epi8(static_cast<char>(follow));
+
+            std::size_t i = 0;
+            for (; i + 33 <= len; i += 32) {
+                const auto first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+                const auto second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + 1));
+                const auto hits =
+                        _mm256_and_si256(_mm256_cmpeq_epi8(first, leads), _mm256_cmpeq_epi8(second, follows));
+
+                if (const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hits)); mask != 0) {
+                    return i + std::countr_zero(mask);
+                }
+            }
+
+            const auto rest = find_pair_sse2(data + i, len - i, lead, follow);
+            return rest == static_cast<std::size_t>(-1) ? rest : i + rest;
+        }
+#endif
+
+        inline find_pair_function select_find_pair() {
+#ifdef __GNUC__
+            // may run before the runtime has looked at the CPU, as this happens during static initialization
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return find_pair_avx2;
+            }
+#endif
+            return find_pair_sse2;
+        }
+#else
+        inline find_pair_function select_find_pair() {
+            return find_pair_scalar;
+        }
+#endif
+
+        // picked once at startup, by what the CPU running the server supports
+        inline const find_pair_function find_pair = select_find_pair();
+    }  // namespace impl
+
+    /**
+     * @brief Finds the first occurrence of two consecutive bytes, such as the YMSG field separator.
+     * @note Vectorized with SSE2 on x86-64, or AVX2 where the CPU supports it.
+     * @param data The data to search.
+     * @param len Length of the data.
+     * @param lead The first byte of the pair.
+     * @param follow The second byte of the pair.
+     * @return Offset of the lead byte of the first occurrence, or -1 if the pair doesn't occur.
+     */
+    inline std::size_t find_byte_pair(const std::byte *data, std::size_t len, std::byte lead, std::byte follow) {
+        return impl::find_pair(data, len, lead, follow);
+    }
+}  // namespace net
+
+#undef NET_SCAN_X86
@@ -0,0 +1,189 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <net/buffer_pool.h>
+#include <net/packet.h>
+#include <net/socket.h>
+
+namespace net {
+    /**
+     * @brief Outgoing data kept as separate segments, so that it can be sent with a single vectored write instead
+     * of being copied into one contiguous buffer first.
+     */
+    struct gather_list {
+        // segments described per vectored write; anything beyond is left for the next write
+        constexpr static std::size_t MAX_VECTORS_PER_WRITE = 64;
+
+        using shared_payload = std::shared_ptr<const std::vector<std::byte>>;
+
+        /**
+         * @brief Construct and serialize an object into a segment of its own.
+         * @tparam T The type of the object. Must satisfy serializable.
+         * @tparam As The types of the arguments to forward to the constructor of T.
+         * @param args The arguments to forward to the constructor of T.
+         */
+        template<typename T, typename... As>
+        void emplace(As &&... args) {
+            serializer s;
+            s.emplace<T>(std::forward<As>(args)...);
+            append(std::move(s));
+        }
+
+        /**
+         * @brief Appends serialized data as a segment, without copying it.
+         * @param s The serializer holding the data.
+         */
+        void append(serializer &&s) {
+            if (s.size() == 0) {
+                return;
+            }
+
+            size_ += s.size();
+            segments_.push_back({std::move(s), nullptr});
+        }
+
+        /**
+         * @brief Appends a pre-encoded payload that may be shared with other lists, without copying it.
+         * @param payload The payload.
+         */
+        void append(shared_payload payload) {
+            if (payload == nullptr || payload->empty()) {
+                return;
+            }
+
+            const auto length = payload->size();
+            append(std::move(payload), 0, length);
+        }
+
+        /**
+         * @brief Appends part of a pre-encoded payload that may be shared with other lists, without copying it.
+         * @param payload The payload.
+         * @param offset Offset of the part within the payload.
+         * @param length Length of the part.
+         */
+        void append(shared_payload payload, std::size_t offset, std::size_t length) {
+            if (payload == nullptr || length == 0) {
+                return;
+            }
+
+            size_ += length;
+            segments_.push_back({serializer(), std::move(payload), offset, length});
+        }
+
+        /**
+         * @brief Describes the data as scatter/gather elements, skipping data that was already sent.
+         * @param vectors Output buffer for the elements.
+         * @param offset Number of bytes at the front of the list to skip.
+         * @return The number of elements written into vectors.
+         */
+        std::size_t io_vectors(std::span<io_vector> vectors, std::size_t offset = 0) const {
+            std::size_t count = 0;
+
+            for (const auto &segment: segments_) {
+                if (count == vectors.size()) {
+                    break;
+                }
+
+                auto data = segment.data();
+                if (offset >= data.size()) {
+                    offset -= data.size();
+                    continue;
+                }
+
+                data = data.subspan(offset);
+                offset = 0;
+                vectors[count++] = impl::make_io_vector(data.data(), data.size());
+            }
+
+            return count;
+        }
+
+        /**
+         * @brief Sends as much of the data as the socket takes with a single vectored write.
+         * @param sock The socket to write to.
+         * @param offset Number of bytes at the front of the list that were already sent.
+         * @return The number of bytes written, or -1 on error.
+         */
+        std::int64_t send(socket &sock, std::size_t offset = 0) const {
+            std::array<io_vector, MAX_VECTORS_PER_WRITE> vectors{};
+            const auto count = io_vectors(vectors, offset);
+
+            return sock.write_vectored(std::span(vectors.data(), count));
+        }
+
+        /**
+         * @brief Gets the number of segments.
+         * @return The number of segments.
+         */
+        std::size_t segment_count() const {
+            return segments_.size();
+        }
+
+        /**
+         * @brief Gets the total length of the data.
+         * @return The total length of all segments.
+         */
+        std::size_t size() const {
+            return size_;
+        }
+
+        /**
+         * @brief Calls a function with the data of every segment, in order.
+         * @tparam F The type of the function.
+         * @param f The function, taking a std::span<const std::byte>.
+         */
+        template<typename F>
+        void for_each_segment(F &&f) const {
+            for (const auto &segment: segments_) {
+                f(segment.data());
+            }
+        }
+
+    private:
+        struct segment {
+            serializer owned;
+            shared_payload shared;
+
+            // the part of the shared payload the segment covers
+            std::size_t offset = 0;
+            std::size_t length = 0;
+
+            std::span<const std::byte> data() const {
+                return shared != nullptr ? std::span<const std::byte>(*shared).subspan(offset, length) : owned.data();
+            }
+        };
+
+        std::vector<segment, pool_allocator<segment>> segments_;
+        std::size_t size_ = 0;
+    };
+}  // namespace net
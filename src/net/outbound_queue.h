@@ -0,0 +1,171 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+
+#include <net/buffer_pool.h>
+#include <net/gather_list.h>
+#include <net/socket.h>
+
+namespace net {
+    /**
+     * @brief Frames waiting to be written to a connection, described as one scatter/gather list so that everything
+     * queued during a tick goes out with a single vectored write.
+     * @note The queue is congested once it holds more than the high watermark, and stays so until it drains below the
+     * low watermark; producers of optional traffic are expected to hold back while it is.
+     */
+    struct outbound_queue {
+        /**
+         * @brief Constructor.
+         * @param high_watermark Queued bytes at which the queue becomes congested.
+         * @param low_watermark Queued bytes at which a congested queue stops being congested.
+         */
+        explicit outbound_queue(std::size_t high_watermark = 262144, std::size_t low_watermark = 65536)
+          : high_watermark_(high_watermark), low_watermark_(low_watermark) {}
+
+        /**
+         * @brief Appends a frame to the back of the queue.
+         * @note Frames already queued are never moved, so data described by io_vectors() stays valid.
+         * @param frame The frame.
+         */
+        void push(gather_list &&frame) {
+            if (frame.size() == 0) {
+                return;
+            }
+
+            size_ += frame.size();
+            frames_.push_back(std::move(frame));
+
+            if (size_ >= high_watermark_) {
+                congested_ = true;
+            }
+        }
+
+        /**
+         * @brief Describes the queued data as scatter/gather elements, starting with the first unsent byte.
+         * @param vectors Output buffer for the elements.
+         * @return The number of elements written into vectors.
+         */
+        std::size_t io_vectors(std::span<io_vector> vectors) const {
+            std::size_t count = 0;
+            auto offset = offset_;
+
+            for (const auto &frame: frames_) {
+                if (count == vectors.size()) {
+                    break;
+                }
+
+                count += frame.io_vectors(vectors.subspan(count), offset);
+                offset = 0;
+            }
+
+            return count;
+        }
+
+        /**
+         * @brief Writes as much of the queued data as the socket takes with a single vectored write.
+         * @param sock The socket to write to.
+         * @return The number of bytes written, or -1 on error.
+         */
+        std::int64_t send(socket &sock) {
+            std::array<io_vector, gather_list::MAX_VECTORS_PER_WRITE> vectors{};
+            const auto count = io_vectors(vectors);
+
+            const auto bytes_written = sock.write_vectored(std::span(vectors.data(), count));
+            if (bytes_written > 0) {
+                consume(bytes_written);
+            }
+
+            return bytes_written;
+        }
+
+        /**
+         * @brief Drops written bytes from the front of the queue.
+         * @param length Number of bytes written.
+         */
+        void consume(std::size_t length) {
+            size_ -= length;
+            offset_ += length;
+
+            while (!frames_.empty() && offset_ >= frames_.front().size()) {
+                offset_ -= frames_.front().size();
+                frames_.pop_front();
+            }
+
+            if (size_ <= low_watermark_) {
+                congested_ = false;
+            }
+        }
+
+        /**
+         * @brief Drops every queued frame.
+         */
+        void clear() {
+            frames_.clear();
+            size_ = 0;
+            offset_ = 0;
+            congested_ = false;
+        }
+
+        /**
+         * @brief Checks whether the queue went past the high watermark and hasn't drained below the low one since.
+         * @return true if the queue is congested, false otherwise.
+         */
+        bool congested() const {
+            return congested_;
+        }
+
+        /**
+         * @brief Checks whether the queue is empty.
+         * @return true if no data is queued, false otherwise.
+         */
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        /**
+         * @brief Gets the number of bytes still to be written.
+         * @return The number of queued bytes.
+         */
+        std::size_t size() const {
+            return size_;
+        }
+
+    private:
+        std::deque<gather_list, pool_allocator<gather_list>> frames_;
+
+        // bytes of the first frame that were already written
+        std::size_t offset_ = 0;
+        std::size_t size_ = 0;
+
+        std::size_t high_watermark_;
+        std::size_t low_watermark_;
+        bool congested_ = false;
+    };
+}  // namespace net
@@ -23,10 +23,15 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <iterator>
 #include <span>
+#include <utility>
 #include <vector>
 
+#include <net/buffer_pool.h>
+#include <net/byte_scan.h>
+
 namespace net {
 //    // MSVC doesn't like our concepts, so we'll just get rid of them... for now.
 //    template<typename T>
@@ -41,15 +46,42 @@ namespace net {
 
     struct serializer {
         using value_type = std::byte;
-        using iterator = std::vector<value_type>::iterator;
-        using const_iterator = std::vector<value_type>::const_iterator;
+        using iterator = value_type *;
+        using const_iterator = const value_type *;
+
+        // capacity of the first block, enough for a header and a handful of fields
+        constexpr static std::size_t INITIAL_CAPACITY = 256;
+
+        serializer() = default;
+
+        serializer(serializer &&other) noexcept
+          : buffer_(std::exchange(other.buffer_, nullptr)), size_(std::exchange(other.size_, 0)),
+            capacity_(std::exchange(other.capacity_, 0)) {}
+
+        serializer &operator=(serializer &&other) noexcept {
+            if (this != &other) {
+                buffer_pool::release(buffer_, capacity_);
+                buffer_ = std::exchange(other.buffer_, nullptr);
+                size_ = std::exchange(other.size_, 0);
+                capacity_ = std::exchange(other.capacity_, 0);
+            }
+
+            return *this;
+        }
+
+        serializer(const serializer &) = delete;
+        serializer &operator=(const serializer &) = delete;
+
+        ~serializer() {
+            buffer_pool::release(buffer_, capacity_);
+        }
 
         /**
          * @brief Begin iterator.
          * @return An iterator to the beginning of the serialized data.
          */
         iterator begin() {
-            return buffer_.begin();
+            return buffer_;
         }
 
         /**
@@ -57,7 +89,7 @@ namespace net {
          * @return An iterator to the beginning of the serialized data.
          */
         const_iterator begin() const {
-            return buffer_.begin();
+            return buffer_;
         }
 
         /**
@@ -65,7 +97,7 @@ namespace net {
          * @return An iterator to the end of the serialized data.
          */
         iterator end() {
-            return buffer_.end();
+            return buffer_ + size_;
         }
 
         /**
@@ -73,7 +105,28 @@ namespace net {
          * @return An iterator to the end of the serialized data.
          */
         const_iterator end() const {
-            return buffer_.end();
+            return buffer_ + size_;
+        }
+
+        /**
+         * @brief Makes room for data that is about to be serialized, so that it's appended without reallocating.
+         * @param len Total length the buffer should be able to hold.
+         */
+        void reserve(std::size_t len) {
+            if (len <= capacity_) {
+                return;
+            }
+
+            const auto capacity = buffer_pool::block_size(len);
+            auto *buffer = static_cast<std::byte *>(buffer_pool::acquire(capacity));
+
+            if (size_ != 0) {
+                std::memcpy(buffer, buffer_, size_);
+            }
+
+            buffer_pool::release(buffer_, capacity_);
+            buffer_ = buffer;
+            capacity_ = capacity;
         }
 
         /**
@@ -82,8 +135,14 @@ namespace net {
          * @param len Length of the input buffer.
          */
         void serialize(const void *data, std::size_t len) {
-            buffer_.reserve(buffer_.size() + len);
-            std::copy_n(static_cast<const std::byte *>(data), len, std::back_inserter(buffer_));
+            if (size_ + len > capacity_) {
+                reserve(std::max({size_ + len, capacity_ * 2, INITIAL_CAPACITY}));
+            }
+
+            if (len != 0) {
+                std::memcpy(buffer_ + size_, data, len);
+                size_ += len;
+            }
         }
 
         /**
@@ -126,7 +185,7 @@ namespace net {
          * @return The serialized data.
          */
         std::span<const std::byte> data() const {
-            return buffer_;
+            return {buffer_, size_};
         }
 
         /**
@@ -134,11 +193,14 @@ namespace net {
         * @return The length of the serialized data.
         */
         size_t size() const {
-            return buffer_.size();
+            return size_;
         }
 
     private:
-        std::vector<std::byte> buffer_;
+        // pooled block, handed back to the pool once the frame it holds was sent
+        std::byte *buffer_ = nullptr;
+        std::size_t size_ = 0;
+        std::size_t capacity_ = 0;
     };
 
     struct deserializer {
@@ -148,6 +210,15 @@ namespace net {
          */
         explicit deserializer(std::span<const std::byte> data) : data_(data) {}
 
+        /**
+         * @brief Constructor.
+         * @note For data that wraps around the end of a ring buffer.
+         * @param data The first part of the data to dissect and deserialize.
+         * @param next The part of the data that follows data.
+         */
+        deserializer(std::span<const std::byte> data, std::span<const std::byte> next)
+          : data_(data.empty() ? next : data), next_(data.empty() ? std::span<const std::byte>() : next) {}
+
         /**
          * @brief Deserialize data.
          * @param data Output buffer.
@@ -155,24 +226,65 @@ namespace net {
          * @return true if the data was deserialized, false otherwise.
          */
         bool deserialize(void *data, size_t len) {
-            if (data_.size() < len)
+            if (size() < len)
                 return false;
 
-            std::memcpy(data, data_.data(), len);
-            data_ = data_.subspan(len);
+            const auto split = std::min(len, data_.size());
+            std::memcpy(data, data_.data(), split);
+            if (len > split) {
+                std::memcpy(static_cast<std::byte *>(data) + split, next_.data(), len - split);
+            }
 
-            return true;
+            return deserialize_ignore(len);
         }
 
         bool deserialize_ignore(size_t len) {
-            if (data_.size() < len)
+            if (size() < len)
                 return false;
 
-            data_ = data_.subspan(len);
+            if (len < data_.size()) {
+                data_ = data_.subspan(len);
+            } else {
+                data_ = next_.subspan(len - data_.size());
+                next_ = {};
+            }
 
             return true;
         }
 
+        /**
+         * @brief Splits the front of the data off into a deserializer of its own.
+         * @param len Length of the front part.
+         * @return A deserializer over the first len bytes, which are skipped here; an empty one if there isn't enough
+         * data.
+         */
+        deserializer take(size_t len) {
+            if (size() < len)
+                return deserializer({});
+
+            const auto split = std::min(len, data_.size());
+            deserializer front(data_.first(split), next_.first(len - split));
+
+            deserialize_ignore(len);
+            return front;
+        }
+
+        /**
+         * @brief Gets the remaining data as a single span.
+         * @param scratch Buffer that data wrapping around the end of a ring buffer is copied into, so that it can be
+         * returned in one piece; the span points into it in that case.
+         * @return The remaining data.
+         */
+        std::span<const std::byte> contiguous(std::vector<std::byte> &scratch) const {
+            if (next_.empty()) {
+                return data_;
+            }
+
+            scratch.assign(data_.begin(), data_.end());
+            scratch.insert(scratch.end(), next_.begin(), next_.end());
+            return scratch;
+        }
+
         /**
          * @brief Finds the first occurrence of a value in the data.
          * @tparam T The type of the value.
@@ -180,16 +292,35 @@ namespace net {
          */
         template<typename T>
         size_t find_pattern_first(T &value) {
-            if (data_.size() < sizeof(value))
+            if (size() < sizeof(value))
+                return static_cast<size_t>(-1);
+
+            const auto *pattern = reinterpret_cast<const std::byte *>(&value);
+
+            // the part that is contiguous in memory
+            if (const auto offset = find_in(data_, pattern, sizeof(value)); offset != static_cast<size_t>(-1)) {
+                return offset;
+            }
+
+            if (next_.empty())
                 return static_cast<size_t>(-1);
 
-            for (size_t i = 0; i <= (data_.size() - sizeof(value)); i++) {
-                auto d_value = *(T *) (data_.data() + i);
-                if (d_value == value) {
+            // candidates that start in the first part and end in the next one
+            for (size_t i = data_.size() - std::min(data_.size(), sizeof(value) - 1); i < data_.size(); i++) {
+                size_t matched = 0;
+                while (matched < sizeof(value) && at(i + matched) == pattern[matched]) {
+                    matched++;
+                }
+
+                if (matched == sizeof(value)) {
                     return i;
                 }
             }
 
+            if (const auto offset = find_in(next_, pattern, sizeof(value)); offset != static_cast<size_t>(-1)) {
+                return data_.size() + offset;
+            }
+
             return static_cast<size_t>(-1);
         }
 
@@ -223,11 +354,35 @@ namespace net {
         * @return The length of the remaining, serialized data.
         */
         size_t size() const {
-            return data_.size();
+            return data_.size() + next_.size();
         }
 
     private:
+        /**
+         * @brief Finds the first occurrence of a pattern in contiguous data.
+         * @note Two-byte patterns, such as the YMSG field separator, go through the vectorized scanner.
+         * @return offset if the pattern was found, -1 otherwise.
+         */
+        static size_t find_in(std::span<const std::byte> data, const std::byte *pattern, size_t len) {
+            if (len == 2) {
+                return find_byte_pair(data.data(), data.size(), pattern[0], pattern[1]);
+            }
+
+            for (size_t i = 0; i + len <= data.size(); i++) {
+                if (std::memcmp(data.data() + i, pattern, len) == 0) {
+                    return i;
+                }
+            }
+
+            return static_cast<size_t>(-1);
+        }
+
+        std::byte at(size_t offset) const {
+            return offset < data_.size() ? data_[offset] : next_[offset - data_.size()];
+        }
+
         std::span<const std::byte> data_;
+        std::span<const std::byte> next_;
     };
 
 }  // namespace net
@@ -0,0 +1,154 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <utility>
+
+namespace net {
+    /**
+     * @brief Owned file descriptor, closed on destruction.
+     */
+    struct file_descriptor {
+        /**
+         * @brief Constructor.
+         * @param fd The descriptor to take ownership of, or -1.
+         */
+        explicit file_descriptor(int fd = -1) : fd_(fd) {}
+
+        ~file_descriptor() {
+            reset();
+        }
+
+        file_descriptor(const file_descriptor &) = delete;
+        file_descriptor &operator=(const file_descriptor &) = delete;
+
+        file_descriptor(file_descriptor &&other) noexcept : fd_(std::exchange(other.fd_, -1)) {}
+
+        file_descriptor &operator=(file_descriptor &&other) noexcept {
+            if (this != &other) {
+                reset();
+                fd_ = std::exchange(other.fd_, -1);
+            }
+
+            return *this;
+        }
+
+        /**
+         * @brief Closes the descriptor, if any.
+         */
+        void reset() {
+            if (fd_ != -1) {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+
+        /**
+         * @brief Gets the native descriptor.
+         * @return The descriptor, or -1.
+         */
+        int get() const {
+            return fd_;
+        }
+
+        /**
+         * @brief Tests if a descriptor is owned.
+         * @return true if the descriptor is valid, false otherwise.
+         */
+        bool is_valid() const {
+            return fd_ != -1;
+        }
+
+    private:
+        int fd_;
+    };
+
+    /**
+     * @brief Non-blocking kernel pipe, used as the in-kernel buffer between splice calls.
+     */
+    struct pipe {
+        /**
+         * @brief Constructor.
+         * @param capacity Requested capacity in bytes; the kernel default is kept if it can't be changed.
+         */
+        explicit pipe(std::size_t capacity) {
+            int fds[2];
+            if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+                return;
+            }
+
+            read_end_ = file_descriptor(fds[0]);
+            write_end_ = file_descriptor(fds[1]);
+
+            fcntl(fds[1], F_SETPIPE_SZ, static_cast<int>(capacity));
+            const auto actual = fcntl(fds[1], F_GETPIPE_SZ);
+            capacity_ = actual > 0 ? static_cast<std::size_t>(actual) : 0;
+        }
+
+        /**
+         * @brief Tests if the pipe was created.
+         * @return true if the pipe is valid, false otherwise.
+         */
+        bool is_valid() const {
+            return read_end_.is_valid() && write_end_.is_valid();
+        }
+
+        /**
+         * @brief Gets the end data is spliced out of.
+         * @return The read end.
+         */
+        int read_end() const {
+            return read_end_.get();
+        }
+
+        /**
+         * @brief Gets the end data is spliced into.
+         * @return The write end.
+         */
+        int write_end() const {
+            return write_end_.get();
+        }
+
+        /**
+         * @brief Gets the number of bytes the pipe holds.
+         * @return The capacity in bytes.
+         */
+        std::size_t capacity() const {
+            return capacity_;
+        }
+
+    private:
+        file_descriptor read_end_;
+        file_descriptor write_end_;
+        std::size_t capacity_ = 0;
+    };
+}  // namespace net
+
+#endif
@@ -0,0 +1,256 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <net/socket.h>
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace net {
+    /**
+     * @brief Readiness notifier for a set of sockets.
+     * @note Backed by edge-triggered epoll on Linux and by WSAPoll elsewhere. Callers must always drain a socket
+     * until it would block, so both behave the same from the point of view of the event loop.
+     */
+    struct poller {
+        enum interest : std::uint32_t {
+            readable = 1 << 0,
+            writable = 1 << 1,
+            hangup = 1 << 2,
+            error = 1 << 3,
+        };
+
+        struct event {
+            void *data;
+            std::uint32_t events;
+        };
+
+        /**
+         * @brief Constructor.
+         */
+        poller() {
+#ifdef __linux__
+            poll_ = epoll_create1(EPOLL_CLOEXEC);
+#endif
+        }
+
+        /**
+         * @brief Destructor.
+         */
+        ~poller() {
+#ifdef __linux__
+            if (poll_ != -1) {
+                ::close(poll_);
+            }
+#endif
+        }
+
+        poller(const poller &other) = delete;
+
+        poller &operator=(const poller &other) = delete;
+
+        /**
+         * @brief Tests if the poller is usable.
+         * @return true if the poller is valid, false otherwise.
+         */
+        bool is_valid() const {
+#ifdef __linux__
+            return poll_ != -1;
+#else
+            return true;
+#endif
+        }
+
+        /**
+         * @brief Starts watching a socket.
+         * @param socket The native socket handle.
+         * @param events Mask of interest values to watch for.
+         * @param data Opaque pointer reported back with every event of this socket.
+         * @return true if the socket is being watched, false otherwise.
+         */
+        bool add(socket_type socket, std::uint32_t events, void *data) {
+#ifdef __linux__
+            epoll_event ev{to_native(events), {.ptr = data}};
+            return epoll_ctl(poll_, EPOLL_CTL_ADD, socket, &ev) == 0;
+#else
+            sockets_.push_back({socket, to_native(events), 0});
+            data_.push_back(data);
+            return true;
+#endif
+        }
+
+        /**
+         * @brief Changes the set of events watched for a socket.
+         * @param socket The native socket handle.
+         * @param events Mask of interest values to watch for.
+         * @param data Opaque pointer reported back with every event of this socket.
+         * @return true if the socket was updated, false otherwise.
+         */
+        bool modify(socket_type socket, std::uint32_t events, void *data) {
+#ifdef __linux__
+            epoll_event ev{to_native(events), {.ptr = data}};
+            return epoll_ctl(poll_, EPOLL_CTL_MOD, socket, &ev) == 0;
+#else
+            const auto it = find(socket);
+            if (it == sockets_.end()) {
+                return false;
+            }
+
+            it->events = to_native(events);
+            data_[std::distance(sockets_.begin(), it)] = data;
+            return true;
+#endif
+        }
+
+        /**
+         * @brief Stops watching a socket.
+         * @param socket The native socket handle.
+         * @return true if the socket is no longer watched, false otherwise.
+         */
+        bool remove(socket_type socket) {
+#ifdef __linux__
+            return epoll_ctl(poll_, EPOLL_CTL_DEL, socket, nullptr) == 0;
+#else
+            const auto it = find(socket);
+            if (it == sockets_.end()) {
+                return false;
+            }
+
+            data_.erase(data_.begin() + std::distance(sockets_.begin(), it));
+            sockets_.erase(it);
+            return true;
+#endif
+        }
+
+        /**
+         * @brief Waits for events.
+         * @param events Output buffer for the events that fired.
+         * @param timeout_ms Maximum time to wait in milliseconds, or -1 to wait forever.
+         * @return The number of events written into events, or -1 on error.
+         */
+        std::int32_t wait(std::span<event> events, std::int32_t timeout_ms) {
+#ifdef __linux__
+            std::array<epoll_event, 256> native{};
+            const auto count = epoll_wait(
+              poll_, native.data(), static_cast<int>(std::min(native.size(), events.size())), timeout_ms);
+
+            for (std::int32_t i = 0; i < count; i++) {
+                events[i] = {native[i].data.ptr, from_native(native[i].events)};
+            }
+
+            return count;
+#else
+            if (WSAPoll(sockets_.data(), static_cast<ULONG>(sockets_.size()), timeout_ms) == SOCKET_ERROR) {
+                return -1;
+            }
+
+            std::int32_t count = 0;
+            for (std::size_t i = 0; i < sockets_.size() && count < static_cast<std::int32_t>(events.size()); i++) {
+                if (sockets_[i].revents != 0) {
+                    events[count++] = {data_[i], from_native(sockets_[i].revents)};
+                }
+            }
+
+            return count;
+#endif
+        }
+
+    private:
+#ifdef __linux__
+        static constexpr std::uint32_t to_native(std::uint32_t events) {
+            std::uint32_t native = EPOLLET | EPOLLRDHUP;
+
+            if (events & readable)
+                native |= EPOLLIN;
+            if (events & writable)
+                native |= EPOLLOUT;
+
+            return native;
+        }
+
+        static constexpr std::uint32_t from_native(std::uint32_t native) {
+            std::uint32_t events = 0;
+
+            if (native & EPOLLIN)
+                events |= readable;
+            if (native & EPOLLOUT)
+                events |= writable;
+            if (native & (EPOLLHUP | EPOLLRDHUP))
+                events |= hangup;
+            if (native & EPOLLERR)
+                events |= error;
+
+            return events;
+        }
+
+        int poll_;
+#else
+        static constexpr SHORT to_native(std::uint32_t events) {
+            SHORT native = 0;
+
+            if (events & readable)
+                native |= POLLRDNORM;
+            if (events & writable)
+                native |= POLLWRNORM;
+
+            return native;
+        }
+
+        static constexpr std::uint32_t from_native(SHORT native) {
+            std::uint32_t events = 0;
+
+            if (native & POLLRDNORM)
+                events |= readable;
+            if (native & POLLWRNORM)
+                events |= writable;
+            if (native & POLLHUP)
+                events |= hangup;
+            if (native & (POLLERR | POLLNVAL))
+                events |= error;
+
+            return events;
+        }
+
+        std::vector<WSAPOLLFD>::iterator find(socket_type socket) {
+            return std::find_if(sockets_.begin(), sockets_.end(), [socket](const auto &fd) {
+                return fd.fd == socket;
+            });
+        }
+
+        std::vector<WSAPOLLFD> sockets_;
+        std::vector<void *> data_;
+#endif
+    };
+}  // namespace net
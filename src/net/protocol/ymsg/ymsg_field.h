@@ -22,14 +22,17 @@
 
 #pragma once
 
+#include <charconv>
 #include <cstdint>
+#include <iterator>
 
 #include <net/packet.h>
 #include <net/utility.h>
 
+#include <net/protocol/ymsg/ymsg_field_view.h>
 #include <net/protocol/ymsg/structure/ymsg_frame_field.h>
 
-#include <spdlog/spdlog.h>
+#include <logging/logging.h>
 
 namespace net {
     namespace protocol {
@@ -44,21 +47,25 @@ namespace net {
                 deserialize(d);
             }
 
+            /**
+             * @brief Construct the field as a copy of a received one.
+             * @param view The received field.
+             */
+            explicit ymsg_field(const ymsg_field_view &view) : ymsg_frame_field(view.key, view.value) {}
+
             /**
              * @brief Serialize the message header.
              * @note To satisfy serializable.
              * @param s The serializer.
              */
             void serialize(serializer &s) const {
-                auto key = std::to_string(this->key);
+                char key[8];
+                const auto key_end = std::to_chars(std::begin(key), std::end(key), std::uint16_t(this->key)).ptr;
 
-                s.serialize(key.data(), key.size());
+                s.serialize(key, key_end - key);
                 s.serialize(YMSG_FIELD_SEPARATOR);
                 s.serialize(value.data(), value.size());
                 s.serialize(YMSG_FIELD_SEPARATOR);
-
-                printf("Serialize:\n");
-                print_info();
             }
 
             /**
@@ -71,7 +78,7 @@ namespace net {
                 auto key_size = d.find_pattern_first(YMSG_FIELD_SEPARATOR);
 
                 if(key_size == -1) {
-                    spdlog::get("net")->critical("field deserialize error; no key found in field!");
+                    logging::net()->critical("field deserialize error; no key found in field!");
                     return false;
                 }
 
@@ -82,12 +89,20 @@ namespace net {
                 d.deserialize(key_str.data(), key_size);
                 d.deserialize_ignore(2); // ignore separator
 
-                key = (YMSG_FLD_) std::stoi(key_str);
+                std::uint16_t parsed_key = 0;
+                const auto [key_end, error] = std::from_chars(key_str.data(), key_str.data() + key_size, parsed_key);
+
+                if(error != std::errc() || key_end != key_str.data() + key_size) {
+                    logging::net()->critical("field deserialize error; key is not a number!");
+                    return false;
+                }
+
+                key = (YMSG_FLD_) parsed_key;
 
                 auto value_size = d.find_pattern_first(YMSG_FIELD_SEPARATOR);
 
                 if(value_size == -1) {
-                    spdlog::get("net")->critical("field deserialize error; no value found in field!");
+                    logging::net()->critical("field deserialize error; no value found in field!");
                     return false;
                 }
 
@@ -96,18 +111,8 @@ namespace net {
                 d.deserialize(value.data(), value_size);
                 d.deserialize_ignore(2); // ignore separator
 
-                printf("Deserialize:\n");
-                print_info();
-
                 return true;
             }
-
-            void print_info() const {
-                printf("YMSGField (\n");
-                printf("    key = %i\n", (int) key);
-                printf("    value = %s\n", value.data());
-                printf(")\n");
-            }
         };
     }  // namespace protocol
 }  // namespace net
@@ -0,0 +1,229 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include <net/byte_scan.h>
+
+#include <net/protocol/ymsg/enums/ymsg_field_type.hpp>
+
+namespace net {
+    namespace protocol {
+        /**
+         * @brief A field of a received frame, pointing into the buffer the frame was received into.
+         * @note Only valid for as long as that buffer is; copy the value out to keep it.
+         */
+        struct ymsg_field_view {
+            YMSG_FLD_ key{};
+            std::string_view value;
+        };
+
+        /**
+         * @brief The fields of a received frame, parsed one at a time while being iterated instead of being copied
+         * out up front.
+         */
+        struct ymsg_frame_view {
+            struct iterator {
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = ymsg_field_view;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const ymsg_field_view *;
+                using reference = const ymsg_field_view &;
+
+                iterator() = default;
+
+                explicit iterator(std::string_view rest) : rest_(rest) {
+                    ++*this;
+                }
+
+                reference operator*() const {
+                    return field_;
+                }
+
+                pointer operator->() const {
+                    return &field_;
+                }
+
+                iterator &operator++() {
+                    done_ = !next_field(rest_, field_);
+                    if (done_) {
+                        malformed_ = !rest_.empty();
+                        rest_ = {};
+                    }
+
+                    return *this;
+                }
+
+                iterator operator++(int) {
+                    auto previous = *this;
+                    ++*this;
+                    return previous;
+                }
+
+                bool operator==(const iterator &other) const {
+                    return done_ == other.done_ && (done_ || rest_.data() == other.rest_.data());
+                }
+
+                /**
+                 * @brief Checks whether the iteration ended at a malformed field rather than at the end of the body.
+                 * @return true if a field is malformed, false otherwise.
+                 */
+                bool malformed() const {
+                    return malformed_;
+                }
+
+            private:
+                std::string_view rest_;
+                ymsg_field_view field_;
+                bool done_ = true;
+                bool malformed_ = false;
+            };
+
+            /**
+             * @brief Constructor.
+             * @param body The body of the frame; has to outlive the view.
+             */
+            explicit ymsg_frame_view(std::span<const std::byte> body)
+              : body_(reinterpret_cast<const char *>(body.data()), body.size()) {}
+
+            /**
+             * @brief Checks that the whole body is made of well-formed fields, so that iterating it visits all of
+             * them.
+             * @return true if every field is well-formed, false otherwise.
+             */
+            bool valid() const {
+                return count().has_value();
+            }
+
+            /**
+             * @brief Counts the fields, checking that every one of them is well-formed.
+             * @return The number of fields, or nothing if a field is malformed.
+             */
+            std::optional<std::size_t> count() const {
+                auto rest = body_;
+                ymsg_field_view field;
+                std::size_t fields = 0;
+
+                while (!rest.empty()) {
+                    if (!next_field(rest, field)) {
+                        return std::nullopt;
+                    }
+
+                    fields++;
+                }
+
+                return fields;
+            }
+
+            /**
+             * @brief Finds the first occurrence of a field.
+             * @param key The key of the field.
+             * @return The value of the field, or nothing if the frame doesn't have it.
+             */
+            std::optional<std::string_view> find(YMSG_FLD_ key) const {
+                for (const auto &field: *this) {
+                    if (field.key == key) {
+                        return field.value;
+                    }
+                }
+
+                return std::nullopt;
+            }
+
+            iterator begin() const {
+                return iterator(body_);
+            }
+
+            iterator end() const {
+                return {};
+            }
+
+            /**
+             * @brief Checks whether the frame has no fields.
+             * @return true if the body is empty, false otherwise.
+             */
+            bool empty() const {
+                return body_.empty();
+            }
+
+        private:
+            // YMSG_FIELD_SEPARATOR as it appears on the wire
+            constexpr static std::string_view SEPARATOR{"\xC0\x80", 2};
+
+            /**
+             * @brief Finds the next separator.
+             * @param data The data to search.
+             * @param from Offset to start searching at.
+             * @return Offset of the separator, or npos if there's none.
+             */
+            static std::size_t find_separator(std::string_view data, std::size_t from) {
+                const auto offset = find_byte_pair(reinterpret_cast<const std::byte *>(data.data()) + from,
+                                                   data.size() - from, std::byte(SEPARATOR[0]),
+                                                   std::byte(SEPARATOR[1]));
+
+                return offset == static_cast<std::size_t>(-1) ? std::string_view::npos : from + offset;
+            }
+
+            /**
+             * @brief Parses the field at the front of the data.
+             * @param rest The data; advanced past the field.
+             * @param field The parsed field.
+             * @return true if a well-formed field was parsed, false otherwise.
+             */
+            static bool next_field(std::string_view &rest, ymsg_field_view &field) {
+                const auto key_end = find_separator(rest, 0);
+                if (key_end == std::string_view::npos || key_end == 0) {
+                    return false;
+                }
+
+                std::uint16_t key = 0;
+                const auto [end, error] = std::from_chars(rest.data(), rest.data() + key_end, key);
+                if (error != std::errc() || end != rest.data() + key_end) {
+                    return false;
+                }
+
+                const auto value_begin = key_end + SEPARATOR.size();
+                const auto value_end = find_separator(rest, value_begin);
+                if (value_end == std::string_view::npos) {
+                    return false;
+                }
+
+                field.key = static_cast<YMSG_FLD_>(key);
+                field.value = rest.substr(value_begin, value_end - value_begin);
+                rest.remove_prefix(value_end + SEPARATOR.size());
+
+                return true;
+            }
+
+            std::string_view body_;
+        };
+    }  // namespace protocol
+}  // namespace net
@@ -0,0 +1,163 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+#include <net/gather_list.h>
+#include <net/packet.h>
+#include <net/utility.h>
+
+#include <net/protocol/ymsg/structure/ymsg_frame_field.h>
+#include <net/protocol/ymsg/structure/ymsg_frame_header.h>
+
+#include <logging/logging.h>
+
+namespace net {
+    namespace protocol {
+        /**
+         * @brief Builds a frame in one buffer: the header slot is reserved up front, fields are appended behind it
+         * as they come, and the header is written once the length is known.
+         */
+        struct ymsg_frame_builder {
+            constexpr static std::uint16_t DEFAULT_PROTOCOL_VERSION = 16;
+
+            /**
+             * @brief Constructor.
+             * @param type The type of the message.
+             * @param status The status of the message.
+             * @param session_id The session ID.
+             */
+            explicit ymsg_frame_builder(YES_ type, YES_STATUS_ status = YES_STATUS_OK, std::uint32_t session_id = 0)
+              : type_(type), status_(status), session_id_(session_id) {
+                frame_.reserve(serializer::INITIAL_CAPACITY);
+
+                const std::byte header[sizeof(ymsg_frame_header)]{};
+                frame_.serialize(header, sizeof(header));
+            }
+
+            /**
+             * @brief Appends a field.
+             * @param key The key of the field.
+             * @param value The value of the field.
+             * @return The builder.
+             */
+            ymsg_frame_builder &add(YMSG_FLD_ key, std::string_view value) {
+                char digits[std::numeric_limits<std::uint16_t>::digits10 + 1];
+                const auto end = std::to_chars(std::begin(digits), std::end(digits), std::uint16_t(key)).ptr;
+
+                frame_.serialize(digits, end - digits);
+                frame_.serialize(YMSG_FIELD_SEPARATOR);
+                frame_.serialize(value.data(), value.size());
+                frame_.serialize(YMSG_FIELD_SEPARATOR);
+
+                return *this;
+            }
+
+            /**
+             * @brief Appends a field with a numeric value.
+             * @param key The key of the field.
+             * @param value The value of the field.
+             * @return The builder.
+             */
+            template<std::integral T>
+            ymsg_frame_builder &add(YMSG_FLD_ key, T value) {
+                char digits[std::numeric_limits<T>::digits10 + 2];
+                const auto end = std::to_chars(std::begin(digits), std::end(digits), value).ptr;
+
+                return add(key, std::string_view(digits, end - digits));
+            }
+
+            /**
+             * @brief Sets the status of the message.
+             * @param status The status.
+             */
+            void set_status(YES_STATUS_ status) {
+                status_ = status;
+            }
+
+            /**
+             * @brief Sets the session ID.
+             * @param session_id The session ID.
+             */
+            void set_session_id(std::uint32_t session_id) {
+                session_id_ = session_id;
+            }
+
+            /**
+             * @brief Gets the length of the frame built so far, header included.
+             * @return The length of the frame.
+             */
+            std::size_t size() const {
+                return frame_.size();
+            }
+
+            /**
+             * @brief Writes the header and hands the frame out; the builder is left empty.
+             * @note A body that doesn't fit the 16-bit length of the header can't be sent, and yields an empty list.
+             * @return The frame, as a single segment.
+             */
+            gather_list finish() {
+                gather_list frame;
+
+                const auto length = frame_.size() - sizeof(ymsg_frame_header);
+                if (length > std::numeric_limits<std::uint16_t>::max()) {
+                    logging::net()->error("Frame of type {0} is too long to send ({1} bytes)!", (int) type_,
+                                          length);
+                    frame_ = serializer();
+                    return frame;
+                }
+
+                auto *out = frame_.begin();
+                write(out, YMSG_HEADER_MAGIC);
+                write(out, cvt_endian(DEFAULT_PROTOCOL_VERSION));
+                write(out, cvt_endian(std::uint16_t(0)));
+                write(out, cvt_endian(static_cast<std::uint16_t>(length)));
+                write(out, cvt_endian(static_cast<std::uint16_t>(type_)));
+                write(out, cvt_endian(static_cast<std::uint32_t>(status_)));
+                write(out, cvt_endian(session_id_));
+
+                frame.append(std::move(frame_));
+                return frame;
+            }
+
+        private:
+            template<typename T>
+            static void write(std::byte *&out, T value) {
+                std::memcpy(out, &value, sizeof(value));
+                out += sizeof(value);
+            }
+
+            serializer frame_;
+            YES_ type_;
+            YES_STATUS_ status_;
+            std::uint32_t session_id_;
+        };
+    }  // namespace protocol
+}  // namespace net
@@ -0,0 +1,222 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include <net/gather_list.h>
+#include <net/packet.h>
+#include <net/utility.h>
+
+#include <net/protocol/ymsg/structure/ymsg_frame_field.h>
+#include <net/protocol/ymsg/structure/ymsg_frame_header.h>
+#include <net/protocol/ymsg/ymsg_frame_builder.h>
+
+#include <logging/logging.h>
+
+namespace net {
+    namespace protocol {
+        /**
+         * @brief A reply that is encoded once and then sent any number of times by reference.
+         * @note Fields declared with add_slot() are patch points: their keys are part of the encoding, and their
+         * values are filled in per send, in declaration order. The header is only re-encoded when a send patches
+         * something, which then also covers the length and the session ID.
+         */
+        struct ymsg_frame_template {
+            /**
+             * @brief Constructor.
+             * @param type The type of the message.
+             * @param status The status of the message.
+             */
+            explicit ymsg_frame_template(YES_ type, YES_STATUS_ status = YES_STATUS_OK)
+              : encoded_(sizeof(ymsg_frame_header)) {
+                auto *out = encoded_.data();
+                write(out, YMSG_HEADER_MAGIC);
+                write(out, cvt_endian(ymsg_frame_builder::DEFAULT_PROTOCOL_VERSION));
+                write(out, cvt_endian(std::uint16_t(0)));
+                write(out, cvt_endian(std::uint16_t(0)));
+                write(out, cvt_endian(static_cast<std::uint16_t>(type)));
+                write(out, cvt_endian(static_cast<std::uint32_t>(status)));
+                write(out, cvt_endian(std::uint32_t(0)));
+
+                seal();
+            }
+
+            /**
+             * @brief Appends a field with a fixed value.
+             * @param key The key of the field.
+             * @param value The value of the field.
+             * @return The template.
+             */
+            ymsg_frame_template &add(YMSG_FLD_ key, std::string_view value) {
+                append_key(key);
+                append(value.data(), value.size());
+                append(&YMSG_FIELD_SEPARATOR, sizeof(YMSG_FIELD_SEPARATOR));
+                return seal();
+            }
+
+            /**
+             * @brief Appends a field the value of which is given per send.
+             * @param key The key of the field.
+             * @return The template.
+             */
+            ymsg_frame_template &add_slot(YMSG_FLD_ key) {
+                append_key(key);
+                slots_.push_back(encoded_.size());
+                append(&YMSG_FIELD_SEPARATOR, sizeof(YMSG_FIELD_SEPARATOR));
+                return seal();
+            }
+
+            /**
+             * @brief Gets the number of patch points.
+             * @return The number of fields added with add_slot().
+             */
+            std::size_t slot_count() const {
+                return slots_.size();
+            }
+
+            /**
+             * @brief Describes the reply as a frame, without copying the pre-encoded part.
+             * @param session_id The session ID.
+             * @param values The values of the slots, in the order they were added in; strings or integers.
+             * @return The frame.
+             */
+            template<typename... Vs>
+            gather_list instantiate(std::uint32_t session_id, const Vs &... values) const {
+                gather_list frame;
+
+                if (sizeof...(Vs) != slots_.size()) {
+                    logging::net()->critical("Frame template with {0} slots given {1} values!", slots_.size(),
+                                             sizeof...(Vs));
+                    return frame;
+                }
+
+                if constexpr (sizeof...(Vs) == 0) {
+                    if (session_id == 0) {
+                        frame.append(payload_);
+                        return frame;
+                    }
+                }
+
+                std::array<serializer, sizeof...(Vs)> encoded_values;
+                std::size_t length = body_length();
+                std::size_t index = 0;
+                ((length += encode(encoded_values[index++], values)), ...);
+
+                if (length > std::numeric_limits<std::uint16_t>::max()) {
+                    logging::net()->error("Frame template instance is too long to send ({0} bytes)!", length);
+                    return frame;
+                }
+
+                serializer header;
+                header.serialize(encoded_.data(), sizeof(ymsg_frame_header));
+
+                auto *out = header.begin() + LENGTH_OFFSET;
+                write(out, cvt_endian(static_cast<std::uint16_t>(length)));
+                out = header.begin() + SESSION_ID_OFFSET;
+                write(out, cvt_endian(session_id));
+
+                frame.append(std::move(header));
+
+                auto offset = sizeof(ymsg_frame_header);
+                for (std::size_t i = 0; i < slots_.size(); i++) {
+                    frame.append(payload_, offset, slots_[i] - offset);
+                    frame.append(std::move(encoded_values[i]));
+                    offset = slots_[i];
+                }
+
+                frame.append(payload_, offset, encoded_.size() - offset);
+                return frame;
+            }
+
+        private:
+            // positions of the patched header fields
+            constexpr static std::size_t LENGTH_OFFSET = 8;
+            constexpr static std::size_t SESSION_ID_OFFSET = 16;
+
+            template<typename T>
+            static void write(std::byte *&out, T value) {
+                std::memcpy(out, &value, sizeof(value));
+                out += sizeof(value);
+            }
+
+            static std::size_t encode(serializer &s, std::string_view value) {
+                s.serialize(value.data(), value.size());
+                return value.size();
+            }
+
+            template<std::integral T>
+            static std::size_t encode(serializer &s, T value) {
+                char digits[std::numeric_limits<T>::digits10 + 2];
+                const auto end = std::to_chars(std::begin(digits), std::end(digits), value).ptr;
+                return encode(s, std::string_view(digits, end - digits));
+            }
+
+            std::size_t body_length() const {
+                return encoded_.size() - sizeof(ymsg_frame_header);
+            }
+
+            void append(const void *data, std::size_t len) {
+                const auto *bytes = static_cast<const std::byte *>(data);
+                encoded_.insert(encoded_.end(), bytes, bytes + len);
+            }
+
+            void append_key(YMSG_FLD_ key) {
+                char digits[std::numeric_limits<std::uint16_t>::digits10 + 1];
+                const auto end = std::to_chars(std::begin(digits), std::end(digits), std::uint16_t(key)).ptr;
+
+                append(digits, end - digits);
+                append(&YMSG_FIELD_SEPARATOR, sizeof(YMSG_FIELD_SEPARATOR));
+            }
+
+            /**
+             * @brief Writes the length of the fixed part into the header, and shares the encoding as it is now.
+             * @return The template.
+             */
+            ymsg_frame_template &seal() {
+                auto *out = encoded_.data() + LENGTH_OFFSET;
+                write(out, cvt_endian(static_cast<std::uint16_t>(body_length())));
+
+                payload_ = std::make_shared<const std::vector<std::byte>>(encoded_);
+                return *this;
+            }
+
+            // the header, with the length of the fixed part and no session ID, followed by the fixed part
+            std::vector<std::byte> encoded_;
+            gather_list::shared_payload payload_;
+
+            // offsets into encoded_ where slot values go
+            std::vector<std::size_t> slots_;
+        };
+    }  // namespace protocol
+}  // namespace net
@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+
+#include <net/packet.h>
+
+#include <net/protocol/ymsg/ymsg_header.h>
+
+namespace net {
+    namespace protocol {
+        /**
+         * @brief Splits a byte stream into YMSG frames as it comes in, however it is segmented.
+         * @note A header is parsed once and then kept until its body is complete, so the bytes of a frame are only
+         * looked at again when the body is handed out.
+         */
+        struct ymsg_framer {
+            enum class result : std::uint8_t {
+                // a frame was taken out of the data
+                frame,
+                // the data ends in the middle of a frame; feed the rest of the stream to continue
+                incomplete,
+                // the data is not a YMSG stream
+                invalid,
+            };
+
+            /**
+             * @brief Takes the next frame out of the data.
+             * @param data The stream data. Advanced past everything consumed, which on an incomplete result may
+             * include the header of the frame the body of which is still missing.
+             * @param header The header of the frame; valid on a frame result.
+             * @param body The body of the frame, exactly header.length bytes long; valid on a frame result.
+             * @return The result.
+             */
+            result next(deserializer &data, ymsg_header &header, deserializer &body) {
+                if (!has_header_) {
+                    if (data.size() < sizeof(ymsg_frame_header)) {
+                        return result::incomplete;
+                    }
+
+                    if (!header_.deserialize(data)) {
+                        return result::invalid;
+                    }
+
+                    has_header_ = true;
+                }
+
+                if (data.size() < header_.length) {
+                    return result::incomplete;
+                }
+
+                header = header_;
+                body = data.take(header_.length);
+                has_header_ = false;
+
+                return result::frame;
+            }
+
+        private:
+            ymsg_header header_{};
+            bool has_header_ = false;
+        };
+    }  // namespace protocol
+}  // namespace net
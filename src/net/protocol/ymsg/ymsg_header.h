@@ -31,12 +31,14 @@
 
 namespace net {
     namespace protocol {
-        // deserialize with endian conversion macro
-#define DESERIALIZE_CVT(d, x) \
-  do {                     \
-    if (!d.deserialize(x)) \
-      return false;        \
-    (x) = cvt_endian(x);   \
+        // deserialize with endian conversion macro; goes through a local since packed fields can't be bound to
+        // references
+#define DESERIALIZE_CVT(d, x)   \
+  do {                          \
+    auto value_ = (x);          \
+    if (!d.deserialize(value_)) \
+      return false;             \
+    (x) = cvt_endian(value_);   \
   } while (0)
 
         struct ymsg_header : protocol::ymsg_frame_header {
@@ -64,10 +66,13 @@ namespace net {
              * @return true if the message header was successfully deserialized, false otherwise.
              */
             bool deserialize(deserializer &d) {
-                if (!d.deserialize(magic)) {
+                std::uint32_t magic_value;
+                if (!d.deserialize(magic_value)) {
                     return false;
                 }
 
+                magic = magic_value;
+
                 if (magic != YMSG_HEADER_MAGIC) {
                     return false;
                 }
@@ -76,17 +81,19 @@ namespace net {
                 DESERIALIZE_CVT(d, vendor_id);
                 DESERIALIZE_CVT(d, length);
 
-                if (!d.deserialize((std::uint16_t &) type)) {
+                std::uint16_t type_value;
+                if (!d.deserialize(type_value)) {
                     return false;
                 }
 
-                type = (YES_) cvt_endian((std::uint16_t) type);
+                type = (YES_) cvt_endian(type_value);
 
-                if (!d.deserialize((std::int32_t &) status)) {
+                std::int32_t status_value;
+                if (!d.deserialize(status_value)) {
                     return false;
                 }
 
-                status = (YES_STATUS_) cvt_endian((std::int32_t) status);
+                status = (YES_STATUS_) cvt_endian(status_value);
 
                 DESERIALIZE_CVT(d, session_id);
 
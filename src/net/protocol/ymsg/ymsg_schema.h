@@ -0,0 +1,359 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string_view>
+
+#include <net/protocol/ymsg/enums/ymsg_field_type.hpp>
+#include <net/protocol/ymsg/enums/ymsg_message_type.hpp>
+#include <net/protocol/ymsg/ymsg_field_view.h>
+
+namespace net {
+    namespace protocol {
+        namespace impl {
+            /**
+             * @brief Converts field values to the type of the member they are stored in.
+             * @tparam T The type of the member.
+             */
+            template<typename T>
+            struct ymsg_value;
+
+            template<>
+            struct ymsg_value<std::string_view> {
+                static bool parse(std::string_view value, std::string_view &out) {
+                    out = value;
+                    return true;
+                }
+            };
+
+            template<std::integral T>
+            struct ymsg_value<T> {
+                static bool parse(std::string_view value, T &out) {
+                    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), out);
+                    return error == std::errc() && end == value.data() + value.size();
+                }
+            };
+
+            template<typename T>
+            struct ymsg_value<std::optional<T>> {
+                static bool parse(std::string_view value, std::optional<T> &out) {
+                    T parsed{};
+                    if (!ymsg_value<T>::parse(value, parsed)) {
+                        return false;
+                    }
+
+                    out = parsed;
+                    return true;
+                }
+            };
+
+            template<typename T>
+            struct member_pointer;
+
+            template<typename C, typename T>
+            struct member_pointer<T C::*> {
+                using class_type = C;
+                using value_type = T;
+            };
+        }  // namespace impl
+
+        /**
+         * @brief The values of a field that may occur more than once in a frame, converted as they are iterated.
+         * @note Points into the frame; only valid for as long as the frame view it was parsed from is.
+         * @tparam T The type of the values; std::string_view or an integral type.
+         */
+        template<typename T>
+        struct ymsg_repeated {
+            struct iterator {
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+
+                iterator() = default;
+
+                iterator(ymsg_frame_view::iterator it, YMSG_FLD_ key) : it_(it), key_(key) {
+                    skip();
+                }
+
+                T operator*() const {
+                    T value{};
+                    impl::ymsg_value<T>::parse(it_->value, value);
+                    return value;
+                }
+
+                iterator &operator++() {
+                    ++it_;
+                    skip();
+                    return *this;
+                }
+
+                iterator operator++(int) {
+                    auto previous = *this;
+                    ++*this;
+                    return previous;
+                }
+
+                bool operator==(const iterator &other) const {
+                    return it_ == other.it_;
+                }
+
+            private:
+                void skip() {
+                    while (it_ != ymsg_frame_view::iterator() && it_->key != key_) {
+                        ++it_;
+                    }
+                }
+
+                ymsg_frame_view::iterator it_;
+                YMSG_FLD_ key_{};
+            };
+
+            iterator begin() const {
+                return frame_ != nullptr ? iterator(frame_->begin(), key_) : iterator();
+            }
+
+            iterator end() const {
+                return {};
+            }
+
+            /**
+             * @brief Gets the number of occurrences.
+             * @return The number of values.
+             */
+            std::size_t size() const {
+                return count_;
+            }
+
+            bool empty() const {
+                return count_ == 0;
+            }
+
+            /**
+             * @brief Parses one more occurrence of the field.
+             * @note Called by the schema while it walks the frame.
+             * @return true if the value converts to T, false otherwise.
+             */
+            bool add(const ymsg_frame_view &frame, YMSG_FLD_ key, std::string_view value) {
+                T parsed{};
+                if (!impl::ymsg_value<T>::parse(value, parsed)) {
+                    return false;
+                }
+
+                frame_ = &frame;
+                key_ = key;
+                count_++;
+                return true;
+            }
+
+        private:
+            const ymsg_frame_view *frame_ = nullptr;
+            YMSG_FLD_ key_{};
+            std::size_t count_ = 0;
+        };
+
+        enum class ymsg_presence : std::uint8_t {
+            // a frame without the field is rejected
+            required,
+            // the member keeps its default value if the frame doesn't have the field
+            optional,
+        };
+
+        /**
+         * @brief Declares a field a message reads, and the member its value is stored in.
+         * @note Supported member types are std::string_view, integral types, std::optional of either, and
+         * ymsg_repeated of the first two for fields that may occur more than once. Of any other field, only the
+         * first occurrence is kept.
+         * @tparam Key The key of the field.
+         * @tparam Member Pointer to the member of the message.
+         * @tparam Presence Whether frames must have the field.
+         */
+        template<YMSG_FLD_ Key, auto Member, ymsg_presence Presence>
+        struct ymsg_field_rule {
+            using message_type = typename impl::member_pointer<decltype(Member)>::class_type;
+            using value_type = typename impl::member_pointer<decltype(Member)>::value_type;
+
+            constexpr static YMSG_FLD_ key = Key;
+            constexpr static ymsg_presence presence = Presence;
+
+            static bool assign(message_type &message, const ymsg_frame_view &frame, std::string_view value,
+                               bool first) {
+                if constexpr (requires(value_type &v) { v.add(frame, Key, value); }) {
+                    return (message.*Member).add(frame, Key, value);
+                } else {
+                    return !first || impl::ymsg_value<value_type>::parse(value, message.*Member);
+                }
+            }
+        };
+
+        template<YMSG_FLD_ Key, auto Member>
+        using ymsg_required = ymsg_field_rule<Key, Member, ymsg_presence::required>;
+
+        template<YMSG_FLD_ Key, auto Member>
+        using ymsg_optional = ymsg_field_rule<Key, Member, ymsg_presence::optional>;
+
+        enum class ymsg_schema_status : std::uint8_t {
+            ok,
+            // a required field is missing
+            missing_field,
+            // the value of a field doesn't convert to the type of its member
+            malformed_field,
+            // the body isn't made of well-formed fields
+            malformed_frame,
+        };
+
+        struct ymsg_schema_result {
+            ymsg_schema_status status = ymsg_schema_status::ok;
+
+            // the field that is missing or malformed
+            YMSG_FLD_ key{};
+
+            // fields walked; all of them on success, otherwise the ones up to where the walk stopped
+            std::size_t fields = 0;
+
+            explicit operator bool() const {
+                return status == ymsg_schema_status::ok;
+            }
+        };
+
+        /**
+         * @brief The fields a message type reads, extracted into a typed message in a single pass over a frame, which
+         * also checks that the frame is made of well-formed fields and counts them.
+         * @note Keys are mapped to rules through a table built at compile time, so every field of the frame costs
+         * one lookup no matter how many fields the schema has.
+         * @tparam Type The message type the schema is for.
+         * @tparam Message The type of the message the fields are stored in.
+         * @tparam Rules The fields; see ymsg_field_rule.
+         */
+        template<YES_ Type, typename Message, typename... Rules>
+        struct ymsg_schema {
+            using message_type = Message;
+            constexpr static YES_ type = Type;
+
+            static_assert(sizeof...(Rules) > 0 && sizeof...(Rules) <= 64, "a schema reads 1 to 64 fields");
+            static_assert((std::same_as<typename Rules::message_type, Message> && ...),
+                          "rules have to point at members of the message");
+
+            /**
+             * @brief Extracts the fields of a frame.
+             * @param frame The fields of the frame; has to outlive message, which points into it.
+             * @param message The message to fill in.
+             * @return The result; on failure, message is only partially filled in.
+             */
+            static ymsg_schema_result parse(const ymsg_frame_view &frame, Message &message) {
+                std::uint64_t seen = 0;
+                std::size_t fields = 0;
+
+                auto it = frame.begin();
+                for (; it != frame.end(); ++it) {
+                    const auto &field = *it;
+                    fields++;
+
+                    const auto key = static_cast<std::size_t>(field.key);
+                    if (key >= SLOTS.size() || SLOTS[key] == NO_SLOT) {
+                        continue;
+                    }
+
+                    const auto slot = SLOTS[key];
+                    const auto bit = std::uint64_t(1) << slot;
+
+                    if (!ASSIGN[slot](message, frame, field.value, (seen & bit) == 0)) {
+                        return {ymsg_schema_status::malformed_field, field.key, fields};
+                    }
+
+                    seen |= bit;
+                }
+
+                if (it.malformed()) {
+                    return {ymsg_schema_status::malformed_frame, {}, fields};
+                }
+
+                if (const auto missing = REQUIRED & ~seen; missing != 0) {
+                    return {ymsg_schema_status::missing_field, KEYS[std::countr_zero(missing)], fields};
+                }
+
+                return {.fields = fields};
+            }
+
+            /**
+             * @brief Extracts the fields of a frame into a new message.
+             * @param frame The fields of the frame; has to outlive the message, which points into it.
+             * @return The message, or nothing if the frame doesn't fit the schema.
+             */
+            static std::optional<Message> parse(const ymsg_frame_view &frame) {
+                Message message{};
+                if (!parse(frame, message)) {
+                    return std::nullopt;
+                }
+
+                return message;
+            }
+
+        private:
+            using assign_function = bool (*)(Message &, const ymsg_frame_view &, std::string_view, bool);
+
+            constexpr static std::uint8_t NO_SLOT = 0xFF;
+
+            constexpr static std::array<YMSG_FLD_, sizeof...(Rules)> KEYS{Rules::key...};
+            constexpr static std::array<assign_function, sizeof...(Rules)> ASSIGN{&Rules::assign...};
+
+            constexpr static std::uint64_t REQUIRED = [] {
+                std::uint64_t mask = 0;
+                std::size_t slot = 0;
+                ((mask |= std::uint64_t(Rules::presence == ymsg_presence::required) << slot++), ...);
+                return mask;
+            }();
+
+            // key -> index of its rule, sized to the largest key the schema reads
+            constexpr static auto SLOTS = [] {
+                std::array<std::uint8_t, std::size_t(std::max({Rules::key...})) + 1> slots{};
+                slots.fill(NO_SLOT);
+
+                for (std::size_t slot = 0; slot < KEYS.size(); slot++) {
+                    slots[KEYS[slot]] = static_cast<std::uint8_t>(slot);
+                }
+
+                return slots;
+            }();
+
+            static_assert([] {
+                for (std::size_t slot = 0; slot < KEYS.size(); slot++) {
+                    if (SLOTS[KEYS[slot]] != slot) {
+                        return false;
+                    }
+                }
+
+                return true;
+            }(), "a schema reads each field through one rule only");
+        };
+    }  // namespace protocol
+}  // namespace net
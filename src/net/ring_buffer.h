@@ -0,0 +1,217 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+
+namespace net {
+    /**
+     * @brief Growable circular byte buffer the kernel reads into directly.
+     * @note Storage is allocated on first use, and storage grown past the initial capacity is dropped again once the
+     * buffer drains, so a single burst doesn't pin a large buffer to a mostly idle connection.
+     */
+    struct ring_buffer {
+        using segments = std::array<std::span<std::byte>, 2>;
+        using const_segments = std::array<std::span<const std::byte>, 2>;
+
+        /**
+         * @brief Constructor.
+         * @param initial_capacity Capacity allocated on first use; rounded up to a power of two.
+         * @param max_capacity Capacity the buffer may grow up to; rounded up to a power of two.
+         */
+        explicit ring_buffer(std::size_t initial_capacity = 4096, std::size_t max_capacity = 131072)
+          : initial_capacity_(std::bit_ceil(initial_capacity)), max_capacity_(std::bit_ceil(max_capacity)) {}
+
+        /**
+         * @brief Gets the free space, as the two regions before and after the end of the storage.
+         * @note Allocates the storage if needed. Write into the regions in order, then commit().
+         * @return The free regions; the second one is empty if the free space doesn't wrap.
+         */
+        segments writable() {
+            if (data_ == nullptr) {
+                allocate(initial_capacity_);
+            }
+
+            const auto begin = tail_ & (capacity_ - 1);
+            const auto free = capacity_ - size();
+            const auto first = std::min(free, capacity_ - begin);
+
+            return {std::span(data_.get() + begin, first), std::span(data_.get(), free - first)};
+        }
+
+        /**
+         * @brief Marks bytes written into the regions returned by writable() as readable.
+         * @param length Number of bytes written.
+         */
+        void commit(std::size_t length) {
+            tail_ += length;
+        }
+
+        /**
+         * @brief Gets the buffered data, as the two regions before and after the end of the storage.
+         * @return The buffered regions; the second one is empty if the data doesn't wrap.
+         */
+        const_segments readable() const {
+            if (data_ == nullptr) {
+                return {};
+            }
+
+            const auto begin = head_ & (capacity_ - 1);
+            const auto first = std::min(size(), capacity_ - begin);
+
+            return {std::span<const std::byte>(data_.get() + begin, first),
+                    std::span<const std::byte>(data_.get(), size() - first)};
+        }
+
+        /**
+         * @brief Drops bytes from the front of the buffered data.
+         * @param length Number of bytes to drop.
+         */
+        void consume(std::size_t length) {
+            head_ += length;
+
+            if (head_ == tail_) {
+                head_ = tail_ = 0;
+
+                if (capacity_ > initial_capacity_) {
+                    data_.reset();
+                    capacity_ = 0;
+                }
+            }
+        }
+
+        /**
+         * @brief Copies data to the back of the buffer, growing it if needed.
+         * @param data The data to append.
+         * @return true if the data was appended, false if it would exceed the maximum capacity.
+         */
+        bool append(std::span<const std::byte> data) {
+            if (!reserve(data.size())) {
+                return false;
+            }
+
+            const auto [first, second] = writable();
+            const auto split = std::min(first.size(), data.size());
+
+            std::memcpy(first.data(), data.data(), split);
+            std::memcpy(second.data(), data.data() + split, data.size() - split);
+            commit(data.size());
+            return true;
+        }
+
+        /**
+         * @brief Makes sure a number of bytes can be written without wrapping over buffered data.
+         * @param length Number of bytes that must fit.
+         * @return true if the bytes fit, false if they would exceed the maximum capacity.
+         */
+        bool reserve(std::size_t length) {
+            if (capacity_ - size() >= length && data_ != nullptr) {
+                return true;
+            }
+
+            const auto required = std::bit_ceil(std::max(size() + length, initial_capacity_));
+            if (required > max_capacity_) {
+                return false;
+            }
+
+            allocate(std::max(required, capacity_));
+            return true;
+        }
+
+        /**
+         * @brief Grows the buffer one step, up to its maximum capacity.
+         * @return true if the buffer grew, false if it is already at its maximum capacity.
+         */
+        bool grow() {
+            if (capacity_ >= max_capacity_) {
+                return false;
+            }
+
+            allocate(data_ == nullptr ? initial_capacity_ : capacity_ * 2);
+            return true;
+        }
+
+        /**
+         * @brief Gets the number of buffered bytes.
+         * @return The number of buffered bytes.
+         */
+        std::size_t size() const {
+            return tail_ - head_;
+        }
+
+        /**
+         * @brief Tests if the buffer holds no data.
+         * @return true if the buffer is empty, false otherwise.
+         */
+        bool empty() const {
+            return head_ == tail_;
+        }
+
+        /**
+         * @brief Tests if no more data fits without growing.
+         * @return true if the buffer is full, false otherwise.
+         */
+        bool full() const {
+            return data_ != nullptr && size() == capacity_;
+        }
+
+        /**
+         * @brief Gets the current capacity.
+         * @return The capacity in bytes, 0 if no storage is allocated.
+         */
+        std::size_t capacity() const {
+            return capacity_;
+        }
+
+    private:
+        void allocate(std::size_t capacity) {
+            auto data = std::make_unique_for_overwrite<std::byte[]>(capacity);
+
+            // re-linearize the buffered data at the start of the new storage
+            const auto [first, second] = readable();
+            std::ranges::copy(first, data.get());
+            std::ranges::copy(second, data.get() + first.size());
+
+            tail_ = size();
+            head_ = 0;
+            data_ = std::move(data);
+            capacity_ = capacity;
+        }
+
+        std::unique_ptr<std::byte[]> data_;
+        std::size_t capacity_ = 0;
+        std::size_t initial_capacity_;
+        std::size_t max_capacity_;
+
+        // monotonic positions, masked with the capacity when indexing
+        std::size_t head_ = 0;
+        std::size_t tail_ = 0;
+    };
+}  // namespace net
@@ -26,14 +26,24 @@
 
 #include <net/socket_win32.h>
 
+#else
+
+#include <net/socket_posix.h>
+
 #endif
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <iterator>
+#include <memory>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <utility>
 
+#include <net/ring_buffer.h>
+
 namespace net {
     namespace impl {
         inline void impl_init() {
@@ -80,6 +90,17 @@ namespace net {
             return address_;
         }
 
+        /**
+         * @brief Formats the endpoint as "address:port".
+         * @return The formatted endpoint.
+         */
+        std::string to_string() const {
+            std::array<char, INET_ADDRSTRLEN> address{};
+            inet_ntop(AF_INET, &address_.sin_addr, address.data(), address.size());
+
+            return std::string(address.data()) + ":" + std::to_string(ntohs(address_.sin_port));
+        }
+
     private:
         sockaddr_in address_;
     };
@@ -168,7 +189,7 @@ namespace net {
          */
         void close() {
             if (socket_ != invalid_socket) {
-                closesocket(socket_);
+                impl::close_socket(socket_);
                 socket_ = invalid_socket;
             }
         }
@@ -191,7 +212,17 @@ namespace net {
          */
         std::int32_t
         write_raw(const void *buffer, std::size_t length) {  // NOLINT(readability-make-member-function-const)
-            return send(socket_, static_cast<const char *>(buffer), static_cast<int>(length), 0);
+            return send(socket_, static_cast<const char *>(buffer), static_cast<int>(length), impl::send_flags);
+        }
+
+        /**
+         * @brief Write several memory regions to the net_socket with a single call.
+         * @param vectors The memory regions to send, in order.
+         * @return The number of bytes written, or -1 on error.
+         */
+        // NOLINTNEXTLINE(readability-make-member-function-const)
+        std::int64_t write_vectored(std::span<const io_vector> vectors) {
+            return impl::write_vectored(socket_, vectors);
         }
 
         /**
@@ -206,12 +237,15 @@ namespace net {
 
             do {
                 const auto bytes_read = read_raw(buffer.data(), buffer.size());
+                if (bytes_read < 0 && impl::interrupted()) {
+                    continue;
+                }
+
+                if (bytes_read < 0 && impl::would_block()) {
+                    break;
+                }
+
                 if (bytes_read <= 0) {
-#ifdef WIN32
-                    if (WSAGetLastError() == WSAEWOULDBLOCK) {
-                        break;
-                    }
-#endif
                     return false;
                 }
 
@@ -223,8 +257,49 @@ namespace net {
             return true;
         }
 
+        enum class read_status : std::uint8_t {
+            drained,
+            full,
+            closed,
+        };
+
+        /**
+         * @brief Read from the net_socket straight into the free space of a ring buffer.
+         * @param ring The ring buffer to read into. It is grown as long as the socket fills it up.
+         * @return drained if the socket has no more data for now, full if the ring buffer is at its maximum capacity
+         * and has to be consumed before reading on, or closed if the peer went away or the read failed.
+         */
+        read_status read(ring_buffer &ring) {  // NOLINT(readability-make-member-function-const)
+            while (true) {
+                if (ring.full() && !ring.grow()) {
+                    return read_status::full;
+                }
+
+                const auto [first, second] = ring.writable();
+                std::array<io_vector, 2> vectors{impl::make_io_vector(first.data(), first.size()),
+                                                 impl::make_io_vector(second.data(), second.size())};
+
+                const auto bytes_read =
+                        impl::read_vectored(socket_, std::span(vectors.data(), second.empty() ? 1 : 2));
+                if (bytes_read < 0 && impl::interrupted()) {
+                    continue;
+                }
+
+                if (bytes_read < 0 && impl::would_block()) {
+                    return read_status::drained;
+                }
+
+                if (bytes_read <= 0) {
+                    return read_status::closed;
+                }
+
+                ring.commit(bytes_read);
+            }
+        }
+
         /**
          * @brief Write to the net_socket.
+         * @note Only meant for blocking sockets; a non-blocking socket fails as soon as its send buffer is full.
          * @param container The container to write from.
          * @tparam T The type of the container. Must satisfy socket_buffer.
          * @return true if the write was successful, false otherwise.
@@ -243,6 +318,21 @@ namespace net {
             return true;
         }
 
+        /**
+         * @brief Allows several sockets to bind to the same address and port, letting the kernel spread incoming
+         * connections over them.
+         * @note Only supported on Linux.
+         * @return true if the option was set, false otherwise.
+         */
+        bool set_reuse_port() {  // NOLINT(readability-make-member-function-const)
+#ifdef __linux__
+            const int enable = 1;
+            return setsockopt(socket_, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) == 0;
+#else
+            return false;
+#endif
+        }
+
         /**
          * @brief Listen for incoming connections.
          * @param backlog The maximum length of the queue of pending connections.
@@ -252,27 +342,61 @@ namespace net {
             return ::listen(socket_, backlog) == 0;
         }
 
+        enum class accept_status : std::uint8_t {
+            accepted,
+            drained,
+            failed,
+        };
+
         /**
          * @brief Accept an incoming connection.
-         * @return The accepted net_socket and endpoint, or std::nullopt on error.
+         * @note Connections that are lost before they could be taken, or can't be made non-blocking, are skipped, so
+         * that the ones queued behind them are still accepted.
+         * @param client Set to the accepted net_socket and endpoint.
+         * @return accepted if a connection was taken, drained if none is pending, or failed if the listener can't
+         * accept for now, such as when out of file descriptors.
          */
-        std::optional<std::pair<socket, endpoint>> accept() {  // NOLINT(readability-make-member-function-const)
-            sockaddr_in address;
-            socklen_t length = static_cast<socklen_t>(sizeof(address));
+        // NOLINTNEXTLINE(readability-make-member-function-const)
+        accept_status accept(std::optional<std::pair<socket, endpoint>> &client) {
+            while (true) {
+                sockaddr_in address;
+                socklen_t length = static_cast<socklen_t>(sizeof(address));
+
+                const auto client_socket = ::accept(socket_, reinterpret_cast<sockaddr *>(&address), &length);
+                if (client_socket == invalid_socket) {
+                    if (impl::interrupted() || impl::connection_lost()) {
+                        continue;
+                    }
 
-            const auto client_socket = ::accept(socket_, reinterpret_cast<sockaddr *>(&address), &length);
-            if (client_socket == invalid_socket) {
-                return std::nullopt;
-            }
+                    return impl::would_block() ? accept_status::drained : accept_status::failed;
+                }
+
+                socket accepted(client_socket);
+                if (!accepted.set_non_blocking()) {
+                    continue;
+                }
 
-            // configure non blocking
-//          fcntl(client_socket, F_SETFL, O_NONBLOCK);
-            u_long mode = 1;  // 1 for non-blocking, 0 for blocking
-            if (ioctlsocket(client_socket, FIONBIO, &mode) == SOCKET_ERROR) {
-                // Handle error
+                client.emplace(std::move(accepted), endpoint(address));
+                return accept_status::accepted;
             }
+        }
 
-            return std::make_pair(socket(client_socket), endpoint(address));
+        /**
+         * @brief Switches the net_socket to non-blocking mode.
+         * @return true if the mode was changed, false otherwise.
+         */
+        bool set_non_blocking() {  // NOLINT(readability-make-member-function-const)
+            return impl::set_non_blocking(socket_);
+        }
+
+        /**
+         * @brief Allows the net_socket to bind to an address that is still in TIME_WAIT.
+         * @return true if the option was set, false otherwise.
+         */
+        bool set_reuse_address() {  // NOLINT(readability-make-member-function-const)
+            const int enable = 1;
+            return setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&enable),
+                              sizeof(enable)) == 0;
         }
 
         /**
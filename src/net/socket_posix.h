@@ -0,0 +1,149 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace net {
+    using socket_type = int;
+
+    // scatter/gather element, laid out the way the platform's vectored I/O calls expect it
+    using io_vector = iovec;
+
+    namespace impl {
+        /**
+         * @brief Closes a native socket handle.
+         * @param socket The native socket handle.
+         * @return true if the socket was closed, false otherwise.
+         */
+        inline bool close_socket(socket_type socket) {
+            return ::close(socket) == 0;
+        }
+
+        /**
+         * @brief Switches a native socket handle to non-blocking mode.
+         * @param socket The native socket handle.
+         * @return true if the mode was changed, false otherwise.
+         */
+        inline bool set_non_blocking(socket_type socket) {
+            const auto flags = fcntl(socket, F_GETFL, 0);
+            return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+        }
+
+        /**
+         * @brief Tests if the last socket error means the operation would have blocked.
+         * @return true if the last operation would have blocked, false otherwise.
+         */
+        inline bool would_block() {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        /**
+         * @brief Tests if the last socket error was caused by a signal interrupting the call.
+         * @return true if the call was interrupted, false otherwise.
+         */
+        inline bool interrupted() {
+            return errno == EINTR;
+        }
+
+        /**
+         * @brief Tests if the last accept failed because of the connection it was about to take, rather than the
+         * listener; Linux passes errors already pending on the new connection on to accept.
+         * @return true if only that connection was lost, false otherwise.
+         */
+        inline bool connection_lost() {
+            switch (errno) {
+                case ECONNABORTED:
+                case EPROTO:
+                case EPERM:
+                case ENETDOWN:
+                case ENETUNREACH:
+                case EHOSTDOWN:
+                case EHOSTUNREACH:
+                case ENOPROTOOPT:
+                case EOPNOTSUPP:
+#ifdef ENONET
+                case ENONET:
+#endif
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        /**
+         * @brief Flags passed to every send; a peer that went away must not raise SIGPIPE.
+         */
+        constexpr int send_flags = MSG_NOSIGNAL;
+
+        /**
+         * @brief Builds a scatter/gather element.
+         * @param data Start of the memory region.
+         * @param length Length of the memory region.
+         * @return The scatter/gather element.
+         */
+        inline io_vector make_io_vector(const void *data, std::size_t length) {
+            return {const_cast<void *>(data), length};
+        }
+
+        /**
+         * @brief Reads from a native socket handle into several memory regions at once.
+         * @param socket The native socket handle.
+         * @param vectors The memory regions to fill, in order.
+         * @return The number of bytes read, or -1 on error.
+         */
+        inline std::int64_t read_vectored(socket_type socket, std::span<io_vector> vectors) {
+            msghdr message{};
+            message.msg_iov = vectors.data();
+            message.msg_iovlen = vectors.size();
+
+            return recvmsg(socket, &message, 0);
+        }
+
+        /**
+         * @brief Writes several memory regions to a native socket handle at once.
+         * @param socket The native socket handle.
+         * @param vectors The memory regions to send, in order.
+         * @return The number of bytes written, or -1 on error.
+         */
+        inline std::int64_t write_vectored(socket_type socket, std::span<const io_vector> vectors) {
+            msghdr message{};
+            message.msg_iov = const_cast<io_vector *>(vectors.data());
+            message.msg_iovlen = vectors.size();
+
+            return sendmsg(socket, &message, send_flags);
+        }
+    }  // namespace impl
+}  // namespace net
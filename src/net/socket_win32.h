@@ -25,6 +25,10 @@
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
 namespace net {
     namespace impl {
         inline void wsa_init() {
@@ -38,4 +42,104 @@ namespace net {
     }  // namespace impl
 
     using socket_type = SOCKET;
+
+    // scatter/gather element, laid out the way the platform's vectored I/O calls expect it
+    using io_vector = WSABUF;
+
+    namespace impl {
+        /**
+         * @brief Closes a native socket handle.
+         * @param socket The native socket handle.
+         * @return true if the socket was closed, false otherwise.
+         */
+        inline bool close_socket(socket_type socket) {
+            return closesocket(socket) == 0;
+        }
+
+        /**
+         * @brief Switches a native socket handle to non-blocking mode.
+         * @param socket The native socket handle.
+         * @return true if the mode was changed, false otherwise.
+         */
+        inline bool set_non_blocking(socket_type socket) {
+            u_long mode = 1;  // 1 for non-blocking, 0 for blocking
+            return ioctlsocket(socket, FIONBIO, &mode) != SOCKET_ERROR;
+        }
+
+        /**
+         * @brief Tests if the last socket error means the operation would have blocked.
+         * @return true if the last operation would have blocked, false otherwise.
+         */
+        inline bool would_block() {
+            return WSAGetLastError() == WSAEWOULDBLOCK;
+        }
+
+        /**
+         * @brief Tests if the last socket error was caused by a signal interrupting the call.
+         * @return true if the call was interrupted, false otherwise.
+         */
+        inline bool interrupted() {
+            return WSAGetLastError() == WSAEINTR;
+        }
+
+        /**
+         * @brief Tests if the last accept failed because of the connection it was about to take, rather than the
+         * listener.
+         * @return true if only that connection was lost, false otherwise.
+         */
+        inline bool connection_lost() {
+            const auto error = WSAGetLastError();
+            return error == WSAECONNRESET || error == WSAECONNABORTED;
+        }
+
+        /**
+         * @brief Flags passed to every send.
+         */
+        constexpr int send_flags = 0;
+
+        /**
+         * @brief Builds a scatter/gather element.
+         * @param data Start of the memory region.
+         * @param length Length of the memory region.
+         * @return The scatter/gather element.
+         */
+        inline io_vector make_io_vector(const void *data, std::size_t length) {
+            return {static_cast<ULONG>(length), static_cast<CHAR *>(const_cast<void *>(data))};
+        }
+
+        /**
+         * @brief Reads from a native socket handle into several memory regions at once.
+         * @param socket The native socket handle.
+         * @param vectors The memory regions to fill, in order.
+         * @return The number of bytes read, or -1 on error.
+         */
+        inline std::int64_t read_vectored(socket_type socket, std::span<io_vector> vectors) {
+            DWORD received = 0;
+            DWORD flags = 0;
+
+            if (WSARecv(socket, vectors.data(), static_cast<DWORD>(vectors.size()), &received, &flags, nullptr,
+                        nullptr) == SOCKET_ERROR) {
+                return -1;
+            }
+
+            return received;
+        }
+
+        /**
+         * @brief Writes several memory regions to a native socket handle at once.
+         * @param socket The native socket handle.
+         * @param vectors The memory regions to send, in order.
+         * @return The number of bytes written, or -1 on error.
+         */
+        inline std::int64_t write_vectored(socket_type socket, std::span<const io_vector> vectors) {
+            DWORD sent = 0;
+
+            if (WSASend(socket, const_cast<io_vector *>(vectors.data()), static_cast<DWORD>(vectors.size()), &sent,
+                        send_flags, nullptr, nullptr) == SOCKET_ERROR) {
+                return -1;
+            }
+
+            return sent;
+        }
+    }  // namespace impl
 }  // namespace net
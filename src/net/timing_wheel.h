@@ -0,0 +1,234 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace net {
+    struct timing_wheel;
+
+    /**
+     * @brief Intrusive timer, meant to be embedded in the object it fires for.
+     * @note Scheduling and cancelling are O(1); a timer unlinks itself from its wheel when destroyed.
+     */
+    struct timer {
+        /**
+         * @brief Constructor.
+         * @param data Opaque value handed back with the timer when it expires.
+         */
+        explicit timer(void *data = nullptr) : data_(data) {}
+
+        ~timer() {
+            cancel();
+        }
+
+        timer(const timer &) = delete;
+        timer &operator=(const timer &) = delete;
+
+        /**
+         * @brief Removes the timer from its wheel, if it is scheduled.
+         */
+        void cancel() {
+            if (next_ != nullptr) {
+                prev_->next_ = next_;
+                next_->prev_ = prev_;
+                prev_ = next_ = nullptr;
+            }
+        }
+
+        /**
+         * @brief Checks whether the timer is scheduled.
+         * @return true if the timer is scheduled, false otherwise.
+         */
+        bool scheduled() const {
+            return next_ != nullptr;
+        }
+
+        /**
+         * @brief Gets the tick the timer expires at.
+         * @return The expiry tick; meaningless if the timer isn't scheduled.
+         */
+        std::uint64_t expiry() const {
+            return expiry_;
+        }
+
+        /**
+         * @brief Gets the value given to the constructor.
+         * @return The opaque value.
+         */
+        void *data() const {
+            return data_;
+        }
+
+    private:
+        friend struct timing_wheel;
+
+        // only for list heads
+        struct head_tag {};
+
+        explicit timer(head_tag) : prev_(this), next_(this) {}
+
+        timer *prev_ = nullptr;
+        timer *next_ = nullptr;
+        std::uint64_t expiry_ = 0;
+        void *data_ = nullptr;
+    };
+
+    /**
+     * @brief Hierarchical timing wheel; four levels of 64 slots each, so timers up to 64^4 ticks away are scheduled
+     * and cancelled in O(1), and expiring costs O(1) per tick plus an occasional cascade into the lower levels.
+     * @note Time is counted in ticks whose length is up to the owner; timers expire at tick granularity, never early.
+     */
+    struct timing_wheel {
+        constexpr static std::size_t SLOT_BITS = 6;
+        constexpr static std::size_t SLOTS = std::size_t{1} << SLOT_BITS;
+        constexpr static std::size_t LEVELS = 4;
+
+        // furthest a timer can be scheduled from the current tick; later expiries are clamped, then rescheduled
+        constexpr static std::uint64_t MAX_DELAY = (std::uint64_t{1} << (SLOT_BITS * LEVELS)) - 1;
+
+        /**
+         * @brief Constructor.
+         * @param now The current tick.
+         */
+        explicit timing_wheel(std::uint64_t now = 0) : now_(now) {
+            for (auto &level: slots_) {
+                for (auto &head: level) {
+                    head.prev_ = head.next_ = &head;
+                }
+            }
+        }
+
+        timing_wheel(const timing_wheel &) = delete;
+        timing_wheel &operator=(const timing_wheel &) = delete;
+
+        /**
+         * @brief Schedules a timer, cancelling it first if it is already scheduled.
+         * @param t The timer.
+         * @param expiry The tick to expire at; ticks that already passed expire on the next one.
+         */
+        void schedule(timer &t, std::uint64_t expiry) {
+            t.cancel();
+            t.expiry_ = expiry;
+            insert(t, now_ + 1);
+        }
+
+        /**
+         * @brief Moves the wheel forward, expiring every timer due by the given tick.
+         * @param now The current tick; ticks before the last one given are ignored.
+         * @param on_expired Called with every expired timer, which is no longer scheduled at that point. May
+         * schedule and cancel timers, and destroy timers, including ones that are due in the same tick.
+         * @tparam F The type of the callback.
+         */
+        template<typename F>
+        void advance(std::uint64_t now, F &&on_expired) {
+            while (now_ < now) {
+                now_++;
+
+                // entering a new slot on a level pulls the timers of that slot down, from the top so that nothing
+                // is pulled into a slot that was already emptied
+                std::size_t levels = 1;
+                while (levels < LEVELS && index(now_, levels - 1) == 0) {
+                    levels++;
+                }
+
+                for (auto level = levels - 1; level > 0; level--) {
+                    timer pending(timer::head_tag{});
+                    take(slots_[level][index(now_, level)], pending);
+
+                    // the slot of the current tick on the lowest level is yet to expire
+                    while (pending.next_ != &pending) {
+                        auto &t = *pending.next_;
+                        t.cancel();
+                        insert(t, now_);
+                    }
+                }
+
+                timer due(timer::head_tag{});
+                take(slots_[0][index(now_, 0)], due);
+
+                while (due.next_ != &due) {
+                    auto &t = *due.next_;
+                    t.cancel();
+
+                    // clamped timers may come around before they're due
+                    if (t.expiry_ > now_) {
+                        insert(t, now_ + 1);
+                    } else {
+                        on_expired(t);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Gets the current tick.
+         * @return The last tick the wheel was advanced to.
+         */
+        std::uint64_t now() const {
+            return now_;
+        }
+
+    private:
+        static std::size_t index(std::uint64_t tick, std::size_t level) {
+            return (tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+        }
+
+        void insert(timer &t, std::uint64_t earliest) {
+            auto expiry = std::max(t.expiry_, earliest);
+            expiry = std::min(expiry, now_ + MAX_DELAY);
+
+            std::size_t level = 0;
+            while (level + 1 < LEVELS && expiry - now_ >= (std::uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+                level++;
+            }
+
+            auto &head = slots_[level][index(expiry, level)];
+            t.prev_ = head.prev_;
+            t.next_ = &head;
+            head.prev_->next_ = &t;
+            head.prev_ = &t;
+        }
+
+        // moves every timer of a slot to an empty list head
+        static void take(timer &from, timer &to) {
+            if (from.next_ == &from) {
+                return;
+            }
+
+            to.next_ = from.next_;
+            to.prev_ = from.prev_;
+            to.next_->prev_ = &to;
+            to.prev_->next_ = &to;
+            from.next_ = from.prev_ = &from;
+        }
+
+        std::uint64_t now_;
+        // list heads; a slot is empty when its head links to itself
+        std::array<std::array<timer, SLOTS>, LEVELS> slots_;
+    };
+}  // namespace net
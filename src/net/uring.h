@@ -0,0 +1,387 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifdef __linux__
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace net {
+    /**
+     * @brief Minimal io_uring instance talking to the kernel through raw system calls.
+     * @note Only used by a single thread; the submission and completion queues are not shared.
+     */
+    struct uring {
+        /**
+         * @brief Constructor.
+         * @param entries Number of submission queue entries to request.
+         */
+        explicit uring(std::uint32_t entries) {
+            io_uring_params params{};
+            params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+
+            fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (fd_ < 0 && errno == EINVAL) {
+                // older kernel, retry without the optional flags
+                params = {};
+                fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            }
+
+            if (fd_ < 0) {
+                return;
+            }
+
+            if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+                close();
+                return;
+            }
+
+            ring_size_ = std::max(params.sq_off.array + params.sq_entries * sizeof(std::uint32_t),
+                                  params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+            ring_ = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                         IORING_OFF_SQ_RING);
+            if (ring_ == MAP_FAILED) {
+                ring_ = nullptr;
+                close();
+                return;
+            }
+
+            sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+            auto *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                              IORING_OFF_SQES);
+            if (sqes == MAP_FAILED) {
+                close();
+                return;
+            }
+
+            auto *base = static_cast<std::byte *>(ring_);
+            sqes_ = static_cast<io_uring_sqe *>(sqes);
+            sq_head_ = reinterpret_cast<std::uint32_t *>(base + params.sq_off.head);
+            sq_tail_ = reinterpret_cast<std::uint32_t *>(base + params.sq_off.tail);
+            sq_mask_ = *reinterpret_cast<std::uint32_t *>(base + params.sq_off.ring_mask);
+            sq_entries_ = params.sq_entries;
+            cq_head_ = reinterpret_cast<std::uint32_t *>(base + params.cq_off.head);
+            cq_tail_ = reinterpret_cast<std::uint32_t *>(base + params.cq_off.tail);
+            cq_mask_ = *reinterpret_cast<std::uint32_t *>(base + params.cq_off.ring_mask);
+            cqes_ = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+
+            // identity map the indirection array once, so that sqe i always lives in slot i
+            auto *array = reinterpret_cast<std::uint32_t *>(base + params.sq_off.array);
+            for (std::uint32_t i = 0; i < sq_entries_; i++) {
+                array[i] = i;
+            }
+
+            sq_local_tail_ = *sq_tail_;
+        }
+
+        /**
+         * @brief Destructor.
+         */
+        ~uring() {
+            close();
+        }
+
+        uring(const uring &other) = delete;
+
+        uring &operator=(const uring &other) = delete;
+
+        /**
+         * @brief Tests if the ring was set up successfully.
+         * @return true if the ring is usable, false otherwise.
+         */
+        bool is_valid() const {
+            return fd_ >= 0;
+        }
+
+        /**
+         * @brief Gets the ring file descriptor.
+         * @return The ring file descriptor.
+         */
+        int get() const {
+            return fd_;
+        }
+
+        /**
+         * @brief Grabs a zeroed submission queue entry.
+         * @note Flushes pending entries to the kernel if the queue is full.
+         * @return The entry, or nullptr if the queue is still full.
+         */
+        io_uring_sqe *get_sqe() {
+            if (sq_local_tail_ - std::atomic_ref(*sq_head_).load(std::memory_order_acquire) >= sq_entries_) {
+                submit();
+
+                if (sq_local_tail_ - std::atomic_ref(*sq_head_).load(std::memory_order_acquire) >= sq_entries_) {
+                    return nullptr;
+                }
+            }
+
+            auto *sqe = &sqes_[sq_local_tail_++ & sq_mask_];
+            std::memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+
+        /**
+         * @brief Gets the number of entries that can be prepared before the submission queue is full.
+         * @return The number of free submission queue entries.
+         */
+        std::uint32_t space_left() const {
+            return sq_entries_ - (sq_local_tail_ - std::atomic_ref(*sq_head_).load(std::memory_order_acquire));
+        }
+
+        /**
+         * @brief Hands every prepared entry to the kernel without waiting.
+         * @return The number of entries consumed, or a negative errno value.
+         */
+        int submit() {
+            return enter(0, -1);
+        }
+
+        /**
+         * @brief Hands every prepared entry to the kernel and waits for completions.
+         * @param wait_nr Number of completions to wait for.
+         * @param timeout_ms Maximum time to wait in milliseconds, or -1 to wait forever.
+         * @return The number of entries consumed, or a negative errno value. -ETIME means the wait timed out.
+         */
+        int submit_and_wait(std::uint32_t wait_nr, std::int32_t timeout_ms) {
+            return enter(wait_nr, timeout_ms);
+        }
+
+        /**
+         * @brief Consumes every completion currently posted.
+         * @param callback Invoked with each io_uring_cqe.
+         * @return The number of completions consumed.
+         */
+        template<typename F>
+        std::uint32_t for_each_completion(F &&callback) {
+            auto head = *cq_head_;
+            const auto tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+            const auto count = tail - head;
+
+            for (; head != tail; head++) {
+                callback(cqes_[head & cq_mask_]);
+            }
+
+            std::atomic_ref(*cq_head_).store(head, std::memory_order_release);
+            return count;
+        }
+
+        /**
+         * @brief Registers a provided buffer ring with the kernel.
+         * @param ring Address of the page aligned ring.
+         * @param entries Number of entries in the ring; must be a power of two.
+         * @param group The buffer group ID.
+         * @return true if the ring was registered, false otherwise.
+         */
+        // NOLINTNEXTLINE(readability-make-member-function-const)
+        bool register_buffer_ring(void *ring, std::uint32_t entries, std::uint16_t group) {
+            io_uring_buf_reg reg{};
+            reg.ring_addr = reinterpret_cast<std::uint64_t>(ring);
+            reg.ring_entries = entries;
+            reg.bgid = group;
+
+            return syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PBUF_RING, &reg, 1) == 0;
+        }
+
+    private:
+        int enter(std::uint32_t wait_nr, std::int32_t timeout_ms) {
+            const auto to_submit = sq_local_tail_ - *sq_tail_;
+            std::atomic_ref(*sq_tail_).store(sq_local_tail_, std::memory_order_release);
+
+            std::uint32_t flags = IORING_ENTER_EXT_ARG;
+            __kernel_timespec ts{timeout_ms / 1000, (timeout_ms % 1000) * 1000000LL};
+            io_uring_getevents_arg arg{};
+
+            if (wait_nr > 0) {
+                flags |= IORING_ENTER_GETEVENTS;
+
+                if (timeout_ms >= 0) {
+                    arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+                }
+            }
+
+            const auto result = syscall(__NR_io_uring_enter, fd_, to_submit, wait_nr, flags, &arg, sizeof(arg));
+            return result < 0 ? -errno : static_cast<int>(result);
+        }
+
+        void close() {
+            if (sqes_ != nullptr) {
+                munmap(sqes_, sqes_size_);
+                sqes_ = nullptr;
+            }
+
+            if (ring_ != nullptr) {
+                munmap(ring_, ring_size_);
+                ring_ = nullptr;
+            }
+
+            if (fd_ >= 0) {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+
+        int fd_ = -1;
+        void *ring_ = nullptr;
+        std::size_t ring_size_ = 0;
+        io_uring_sqe *sqes_ = nullptr;
+        std::size_t sqes_size_ = 0;
+
+        std::uint32_t *sq_head_ = nullptr;
+        std::uint32_t *sq_tail_ = nullptr;
+        std::uint32_t sq_mask_ = 0;
+        std::uint32_t sq_entries_ = 0;
+        std::uint32_t sq_local_tail_ = 0;
+
+        std::uint32_t *cq_head_ = nullptr;
+        std::uint32_t *cq_tail_ = nullptr;
+        std::uint32_t cq_mask_ = 0;
+        io_uring_cqe *cqes_ = nullptr;
+    };
+
+    /**
+     * @brief A group of equally sized receive buffers the kernel picks from when a recv completes.
+     */
+    struct uring_buffer_ring {
+        /**
+         * @brief Constructor.
+         * @param ring The ring to register the buffers with.
+         * @param group The buffer group ID used in IOSQE_BUFFER_SELECT requests.
+         * @param count Number of buffers; must be a power of two.
+         * @param size Size of every buffer in bytes.
+         */
+        uring_buffer_ring(uring &ring, std::uint16_t group, std::uint16_t count, std::uint32_t size)
+          : group_(group),
+            count_(count),
+            size_(size),
+            storage_(std::make_unique<std::byte[]>(std::size_t{count} * size)) {
+            ring_size_ = count * sizeof(io_uring_buf);
+            auto *memory = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+            if (memory == MAP_FAILED) {
+                return;
+            }
+
+            ring_ = static_cast<io_uring_buf_ring *>(memory);
+            if (!ring.register_buffer_ring(ring_, count_, group_)) {
+                munmap(ring_, ring_size_);
+                ring_ = nullptr;
+                return;
+            }
+
+            for (std::uint16_t i = 0; i < count_; i++) {
+                recycle(i);
+            }
+
+            publish();
+        }
+
+        /**
+         * @brief Destructor.
+         * @note The ring is unregistered when the owning io_uring instance is closed.
+         */
+        ~uring_buffer_ring() {
+            if (ring_ != nullptr) {
+                munmap(ring_, ring_size_);
+            }
+        }
+
+        uring_buffer_ring(const uring_buffer_ring &other) = delete;
+
+        uring_buffer_ring &operator=(const uring_buffer_ring &other) = delete;
+
+        /**
+         * @brief Tests if the buffers were registered successfully.
+         * @return true if the buffer ring is usable, false otherwise.
+         */
+        bool is_valid() const {
+            return ring_ != nullptr;
+        }
+
+        /**
+         * @brief Gets the buffer group ID.
+         * @return The buffer group ID.
+         */
+        std::uint16_t group() const {
+            return group_;
+        }
+
+        /**
+         * @brief Gets the data the kernel placed into a buffer.
+         * @param id The buffer ID reported in the completion flags.
+         * @param length The number of bytes received.
+         * @return The received bytes.
+         */
+        std::span<const std::byte> data(std::uint16_t id, std::size_t length) const {
+            return {storage_.get() + std::size_t{id} * size_, length};
+        }
+
+        /**
+         * @brief Queues a buffer to be handed back to the kernel.
+         * @note The buffer becomes visible to the kernel after publish().
+         * @param id The buffer ID.
+         */
+        void recycle(std::uint16_t id) {
+            // not ring_->bufs: the kernel header pads the flexible array with an empty struct, which isn't empty
+            // in C++
+            auto &buf = reinterpret_cast<io_uring_buf *>(ring_)[(tail_ + pending_++) & (count_ - 1)];
+            buf.addr = reinterpret_cast<std::uint64_t>(storage_.get() + std::size_t{id} * size_);
+            buf.len = size_;
+            buf.bid = id;
+        }
+
+        /**
+         * @brief Makes every recycled buffer visible to the kernel.
+         */
+        void publish() {
+            tail_ += pending_;
+            pending_ = 0;
+            std::atomic_ref(ring_->tail).store(tail_, std::memory_order_release);
+        }
+
+    private:
+        std::uint16_t group_;
+        std::uint16_t count_;
+        std::uint32_t size_;
+        std::unique_ptr<std::byte[]> storage_;
+
+        io_uring_buf_ring *ring_ = nullptr;
+        std::size_t ring_size_ = 0;
+        std::uint16_t tail_ = 0;
+        std::uint16_t pending_ = 0;
+    };
+}  // namespace net
+
+#endif
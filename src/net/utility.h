@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <bit>
 #include <type_traits>
 
 namespace net {
@@ -38,14 +39,7 @@ namespace net {
     constexpr T cvt_endian(T value) {
         static_assert(sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
 
-        if constexpr (sizeof(T) == 2)
-            return _byteswap_ushort(value);
-
-        if constexpr (sizeof(T) == 4)
-            return _byteswap_ulong(value);
-
-        if constexpr (sizeof(T) == 8)
-            return _byteswap_uint64(value);
+        return std::byteswap(value);
     }
 
 }  // namespace net
@@ -0,0 +1,119 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <server/admission.h>
+#include <server/event_loop.h>
+
+#include <algorithm>
+#include <random>
+
+namespace server {
+    constexpr std::uint32_t TICKS_PER_SECOND = std::chrono::seconds(1) / TIMER_TICK;
+
+    // new connections per second and address, with room for a burst of reconnects
+    constexpr std::uint32_t CONNECT_RATE = 2;
+    constexpr std::uint32_t CONNECT_BURST = 20;
+
+    // connections one address may keep open; generous, as whole offices may sit behind one NAT
+    constexpr std::uint32_t MAX_CONNECTIONS = 64;
+
+    // frames per second and address, over all of its connections
+    constexpr std::uint32_t FRAME_RATE = 200;
+    constexpr std::uint32_t FRAME_BURST = 1000;
+
+    admission_control::admission_control()
+      : entries_(std::make_unique<entry[]>(SLOTS)), seed_(std::random_device()() | 1) {
+        std::fill_n(entries_.get(), SLOTS,
+                    entry{CONNECT_BURST * TICKS_PER_SECOND, FRAME_BURST * TICKS_PER_SECOND, 0, 0});
+    }
+
+    admission_control::slot admission_control::find(const net::endpoint &endpoint) const {
+        const auto address = static_cast<std::uint32_t>(endpoint.get().sin_addr.s_addr);
+        if ((ntohl(address) >> 24) == 127) {
+            return EXEMPT;
+        }
+
+        // seeded multiplicative hash, so that nobody can pick addresses that collide with a victim on purpose
+        const auto hash = static_cast<std::uint32_t>((std::uint64_t{address ^ seed_} * 0x9E3779B97F4A7C15ull) >> 32);
+
+        return hash % SLOTS;
+    }
+
+    bool admission_control::admit(slot s, std::uint64_t now) {
+        if (s == EXEMPT) {
+            return true;
+        }
+
+        auto &e = entries_[s];
+        refill(e, now);
+
+        if (e.connections >= MAX_CONNECTIONS || e.connect_tokens < TICKS_PER_SECOND) {
+            return false;
+        }
+
+        e.connect_tokens -= TICKS_PER_SECOND;
+        e.connections++;
+        return true;
+    }
+
+    void admission_control::release(slot s) {
+        if (s == EXEMPT) {
+            return;
+        }
+
+        auto &e = entries_[s];
+        if (e.connections > 0) {
+            e.connections--;
+        }
+    }
+
+    bool admission_control::allow_frame(slot s, std::uint64_t now) {
+        if (s == EXEMPT) {
+            return true;
+        }
+
+        auto &e = entries_[s];
+        refill(e, now);
+
+        if (e.frame_tokens < TICKS_PER_SECOND) {
+            return false;
+        }
+
+        e.frame_tokens -= TICKS_PER_SECOND;
+        return true;
+    }
+
+    void admission_control::refill(entry &e, std::uint64_t now) const {
+        const auto elapsed = static_cast<std::uint32_t>(now) - e.last_refill;
+        if (elapsed == 0) {
+            return;
+        }
+
+        e.connect_tokens = static_cast<std::uint32_t>(
+                std::min<std::uint64_t>(e.connect_tokens + std::uint64_t{elapsed} * CONNECT_RATE,
+                                        CONNECT_BURST * TICKS_PER_SECOND));
+        e.frame_tokens = static_cast<std::uint32_t>(
+                std::min<std::uint64_t>(e.frame_tokens + std::uint64_t{elapsed} * FRAME_RATE,
+                                        FRAME_BURST * TICKS_PER_SECOND));
+        e.last_refill = static_cast<std::uint32_t>(now);
+    }
+}  // namespace server
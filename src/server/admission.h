@@ -0,0 +1,93 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <net/socket.h>
+
+namespace server {
+    /**
+     * @brief Per source address limits on how fast clients may connect and send frames, and on how many connections
+     * they may keep open.
+     * @note Addresses are hashed into a fixed number of slots without being stored, so the table takes the same memory
+     * however many addresses show up; addresses that end up in the same slot share its limits. Every event loop has
+     * a table of its own, so the limits apply per loop. Loopback addresses are exempt, so that local tools and test
+     * clients aren't throttled.
+     */
+    struct admission_control {
+        using slot = std::uint32_t;
+
+        constexpr static std::size_t SLOTS = 16384;
+
+        // slot of addresses no limits apply to
+        constexpr static slot EXEMPT = SLOTS;
+
+        admission_control();
+
+        /**
+         * @brief Gets the slot keeping the limits of a source address.
+         * @param endpoint The remote endpoint of a client.
+         * @return The slot.
+         */
+        slot find(const net::endpoint &endpoint) const;
+
+        /**
+         * @brief Lets a new connection in if its slot has a connection token left and is below the connection limit.
+         * @param s The slot of the source address.
+         * @param now The current timer tick.
+         * @return true if the connection is admitted and must be released later, false if it must be refused.
+         */
+        bool admit(slot s, std::uint64_t now);
+
+        /**
+         * @brief Gives back the connection an admitted client held.
+         * @param s The slot of the source address.
+         */
+        void release(slot s);
+
+        /**
+         * @brief Takes a frame token from a slot.
+         * @param s The slot of the source address.
+         * @param now The current timer tick.
+         * @return true if the frame may be handled, false if the source is sending too fast.
+         */
+        bool allow_frame(slot s, std::uint64_t now);
+
+    private:
+        // token counts are kept in 1/TICKS_PER_SECOND units, so refilling per tick is integer math
+        struct entry {
+            std::uint32_t connect_tokens;
+            std::uint32_t frame_tokens;
+            std::uint32_t connections;
+            std::uint32_t last_refill;
+        };
+
+        void refill(entry &e, std::uint64_t now) const;
+
+        std::unique_ptr<entry[]> entries_;
+        std::uint32_t seed_;
+    };
+}  // namespace server
@@ -0,0 +1,162 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <server/config.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <string_view>
+#include <thread>
+
+namespace server {
+    namespace {
+        void print_usage(const char *program) {
+            std::printf("Usage: %s [options]\n", program);
+            std::printf("  --address <ip>         address to listen on (default: 127.0.0.1)\n");
+            std::printf("  --port <port>          port to listen on (default: 5050)\n");
+            std::printf("  --io <epoll|io_uring>  I/O backend of the event loop (default: epoll)\n");
+            std::printf("  --threads <count>      number of event loop threads (default: one per CPU on Linux)\n");
+            std::printf("  --pin-threads          pin every event loop thread to its own CPU\n");
+            std::printf("  --dev-login            accept every login without checking credentials, for testing only\n");
+            std::printf("  --relay-port <port>    port of the file transfer relay, as in 5051; unauthenticated, so\n");
+            std::printf("                         only for trusted networks (default: 0, disabled)\n");
+            std::printf("  --spool-dir <path>     directory for spooled file transfers (default: /tmp)\n");
+            std::printf("  --metrics-address <ip> address of the metrics endpoint (default: 127.0.0.1)\n");
+            std::printf("  --metrics-port <port>  port of the metrics endpoint, 0 to disable (default: 5052)\n");
+            std::printf("  --capture <path>       record every frame to <path>.<thread>, for ymredux-replay\n");
+            std::printf("  --trace <path>         trace the dispatch of every frame to <path>.<thread>,\n");
+            std::printf("                         for ymredux-trace2json\n");
+            std::printf("  --log-level <levels>   level of every subsystem, or of some, as in\n");
+            std::printf("                         net=debug,server=trace (default: info); levels below the build's\n");
+            std::printf("                         minimum are compiled out\n");
+            std::printf("  --log-overflow <drop|block>\n");
+            std::printf("                         what to do with log messages when the log queue is full\n");
+            std::printf("                         (default: drop)\n");
+            std::printf("  --help                 show this message\n");
+        }
+
+        template<typename T>
+        bool parse_number(std::string_view text, T &value) {
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc() && end == text.data() + text.size();
+        }
+    }
+
+    std::optional<config> parse_arguments(int argc, char **argv) {
+        config result;
+
+#ifdef __linux__
+        result.threads = std::clamp(std::thread::hardware_concurrency(), 1U, session_table::MAX_SHARDS);
+#endif
+
+        for (int i = 1; i < argc; i++) {
+            const std::string_view option = argv[i];
+
+            if (option == "--help") {
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+
+            if (option == "--pin-threads") {
+                result.pin_threads = true;
+                continue;
+            }
+
+            if (option == "--dev-login") {
+                result.dev_login = true;
+                continue;
+            }
+
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+
+            const std::string_view value = argv[++i];
+
+            if (option == "--address") {
+                result.address = value;
+            } else if (option == "--port") {
+                if (!parse_number(value, result.port)) {
+                    std::fprintf(stderr, "Invalid port: %s\n", argv[i]);
+                    return std::nullopt;
+                }
+            } else if (option == "--relay-port") {
+                if (!parse_number(value, result.relay_port)) {
+                    std::fprintf(stderr, "Invalid relay port: %s\n", argv[i]);
+                    return std::nullopt;
+                }
+            } else if (option == "--spool-dir") {
+                result.spool_directory = value;
+            } else if (option == "--capture") {
+                result.capture_path = value;
+            } else if (option == "--trace") {
+                result.trace_path = value;
+            } else if (option == "--metrics-address") {
+                result.metrics_address = value;
+            } else if (option == "--metrics-port") {
+                if (!parse_number(value, result.metrics_port)) {
+                    std::fprintf(stderr, "Invalid metrics port: %s\n", argv[i]);
+                    return std::nullopt;
+                }
+            } else if (option == "--log-level") {
+                if (!logging::parse_levels(value, result.log)) {
+                    std::fprintf(stderr, "Invalid log levels: %s\n", argv[i]);
+                    return std::nullopt;
+                }
+            } else if (option == "--log-overflow") {
+                if (value == "drop") {
+                    result.log.overflow = logging::overflow_policy::drop;
+                } else if (value == "block") {
+                    result.log.overflow = logging::overflow_policy::block;
+                } else {
+                    std::fprintf(stderr, "Unknown log overflow policy: %s\n", argv[i]);
+                    return std::nullopt;
+                }
+            } else if (option == "--threads") {
+                if (!parse_number(value, result.threads) || result.threads == 0 ||
+                    result.threads > session_table::MAX_SHARDS) {
+                    std::fprintf(stderr, "Invalid thread count: %s\n", argv[i]);
+                    return std::nullopt;
+                }
+            } else if (option == "--io") {
+                if (value == "epoll") {
+                    result.backend = io_backend::epoll;
+                } else if (value == "io_uring") {
+                    result.backend = io_backend::io_uring;
+                } else {
+                    std::fprintf(stderr, "Unknown I/O backend: %s\n", argv[i]);
+                    return std::nullopt;
+                }
+            } else {
+                std::fprintf(stderr, "Unknown option: %s\n", argv[i - 1]);
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+        }
+
+        return result;
+    }
+}  // namespace server
@@ -0,0 +1,75 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include <logging/logging.h>
+
+#include <server/event_loop.h>
+
+namespace server {
+    /**
+     * @brief Startup options of the server.
+     */
+    struct config {
+        std::string address = "127.0.0.1";
+        std::uint16_t port = 5050;
+        io_backend backend = io_backend::epoll;
+
+        // one event loop and listening socket per thread; more than one needs SO_REUSEPORT
+        std::uint32_t threads = 1;
+        bool pin_threads = false;
+
+        // every login is accepted without checking credentials; for development and load testing
+        bool dev_login = false;
+
+        // file transfer relay, on a port of its own; 0 disables it. Off unless asked for, since its tokens are chosen
+        // by the clients and anyone who guesses one can download the transfer
+        std::uint16_t relay_port = 0;
+        std::string spool_directory = "/tmp";
+
+        // Prometheus metrics endpoint; 0 disables it. Loopback only unless told otherwise
+        std::string metrics_address = "127.0.0.1";
+        std::uint16_t metrics_port = 5052;
+
+        // every frame in and out is recorded to "<path>.<shard>" when set, for ymredux-replay
+        std::string capture_path;
+
+        // a span per dispatched frame is written to "<path>.<shard>" when set, for ymredux-trace2json
+        std::string trace_path;
+
+        logging::settings log;
+    };
+
+    /**
+     * @brief Builds the configuration from the command line.
+     * @param argc The argument count, as passed to main.
+     * @param argv The arguments, as passed to main.
+     * @return The configuration, or std::nullopt if the command line is invalid or help was requested.
+     */
+    std::optional<config> parse_arguments(int argc, char **argv);
+}  // namespace server
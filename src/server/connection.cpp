@@ -0,0 +1,310 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <server/connection.h>
+#include <server/event_loop.h>
+#include <server/replies.h>
+#include <server/server.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <logging/logging.h>
+
+namespace server {
+    // queued bytes past which a client is evicted right away instead of waiting out its congestion
+    constexpr std::size_t OUTBOUND_QUEUE_LIMIT = 1048576;
+
+    // a quiet client is pinged after this long, and dropped if it stays quiet until the idle timeout
+    constexpr std::uint64_t PING_INTERVAL = std::chrono::seconds(60) / TIMER_TICK;
+    constexpr std::uint64_t IDLE_TIMEOUT = std::chrono::seconds(180) / TIMER_TICK;
+
+    // time from connecting to YES_HELO, then from YES_HELO to completing YES_USER_LOGIN_2
+    constexpr std::uint64_t HELO_TIMEOUT = std::chrono::seconds(10) / TIMER_TICK;
+    constexpr std::uint64_t LOGIN_TIMEOUT = std::chrono::seconds(30) / TIMER_TICK;
+
+    // bytes of an incomplete frame that may be buffered; handshake frames are small, so a client trickling a large
+    // one before logging in is up to no good
+    constexpr std::size_t MAX_HANDSHAKE_PENDING = 2048;
+    constexpr std::size_t MAX_PENDING = 65536;
+
+    connection::connection(event_loop &loop, std::uint64_t id, net::socket socket, net::endpoint endpoint)
+      : loop_(loop),
+        metrics_(loop.metrics()),
+        recorder_(loop.recorder()),
+        tracer_(loop.tracer()),
+        id_(id),
+        socket_(std::move(socket)),
+        endpoint_(endpoint),
+        admission_slot_(loop.admission().find(endpoint)),
+        last_activity_(loop.timers().now()) {
+        loop_.timers().schedule(liveness_timer_, last_activity_ + PING_INTERVAL);
+        loop_.timers().schedule(login_timer_, last_activity_ + HELO_TIMEOUT);
+        metrics_.connections.add(1);
+    }
+
+    connection::~connection() {
+        if (session_ != nullptr) {
+            loop_.sessions().remove(loop_.shard(), session_);
+        }
+
+        loop_.admission().release(admission_slot_);
+        metrics_.connections.add(-1);
+        metrics_.queued_bytes.add(-static_cast<std::int64_t>(outbound_.size()));
+
+        if (recorder_ != nullptr) {
+            recorder_->closed(id_);
+        }
+
+        dump_flight_recorder(spdlog::level::debug, "closed");
+    }
+
+    bool connection::on_readable() {
+        while (true) {
+            const auto pending = buffer_.size();
+            const auto status = socket_.read(buffer_);
+            metrics_.bytes_received.add(buffer_.size() - pending);
+
+            if (status == net::socket::read_status::closed) {
+                return false;
+            }
+
+            const auto [first, second] = buffer_.readable();
+            net::deserializer frame(first, second);
+            const auto buffered = frame.size();
+
+            const auto ok = dispatch(frame);
+            buffer_.consume(buffered - frame.size());
+
+            if (!ok || !check_pending()) {
+                return false;
+            }
+
+            if (status == net::socket::read_status::drained) {
+                return true;
+            }
+
+            // the buffer is at its maximum capacity and not even one frame could be taken out of it
+            if (buffer_.full()) {
+                logging::net()->critical("Oversized frame from {0}!", endpoint_.to_string());
+                dump_flight_recorder(spdlog::level::warn, "oversized frame");
+                return false;
+            }
+        }
+    }
+
+    bool connection::on_received(std::span<const std::byte> data) {
+        metrics_.bytes_received.add(data.size());
+
+        if (!buffer_.empty()) {
+            if (!buffer_.append(data)) {
+                logging::net()->critical("Oversized frame from {0}!", endpoint_.to_string());
+                dump_flight_recorder(spdlog::level::warn, "oversized frame");
+                return false;
+            }
+
+            const auto [first, second] = buffer_.readable();
+            net::deserializer frame(first, second);
+            const auto buffered = frame.size();
+
+            const auto ok = dispatch(frame);
+            buffer_.consume(buffered - frame.size());
+            return ok && check_pending();
+        }
+
+        // nothing pending, so parse straight out of the event loop's buffer and only keep an incomplete tail
+        net::deserializer frame(data);
+
+        if (!dispatch(frame)) {
+            return false;
+        }
+
+        return buffer_.append(data.last(frame.size())) && check_pending();
+    }
+
+    bool connection::check_pending() const {
+        const auto limit = state_ != session_state::logged_in ? MAX_HANDSHAKE_PENDING : MAX_PENDING;
+        if (buffer_.size() <= limit) {
+            return true;
+        }
+
+        logging::net()->warn("Too much data buffered for an incomplete frame from {0}!", endpoint_.to_string());
+        dump_flight_recorder(spdlog::level::warn, "incomplete frame too large");
+        return false;
+    }
+
+    bool connection::on_timer(net::timer &t) {
+        if (&t == &login_timer_) {
+            logging::net()->info("{0} did not log in in time!", endpoint_.to_string());
+            return false;
+        }
+
+        const auto now = loop_.timers().now();
+        const auto idle = now - last_activity_;
+
+        if (idle >= IDLE_TIMEOUT) {
+            logging::net()->info("{0} timed out!", endpoint_.to_string());
+            return false;
+        }
+
+        // heard from the client since the timer was set, so just move it
+        if (idle < PING_INTERVAL) {
+            loop_.timers().schedule(liveness_timer_, last_activity_ + PING_INTERVAL);
+            return true;
+        }
+
+        write(replies::ping().instantiate(session_id()));
+
+        loop_.timers().schedule(liveness_timer_, last_activity_ + IDLE_TIMEOUT);
+        return !evicted_;
+    }
+
+    void connection::greeted() {
+        // a repeated HELO doesn't buy more time
+        if (state_ != session_state::connected) {
+            return;
+        }
+
+        state_ = session_state::greeted;
+        loop_.timers().schedule(login_timer_, loop_.timers().now() + LOGIN_TIMEOUT);
+    }
+
+    const session &connection::logged_in(std::string_view username) {
+        login_timer_.cancel();
+        state_ = session_state::logged_in;
+
+        // a client logging in again on the same connection starts over with a new session
+        if (session_ != nullptr) {
+            loop_.sessions().remove(loop_.shard(), session_);
+        }
+
+        session_ = loop_.sessions().create(loop_.shard(), username, this, id_);
+        return *session_;
+    }
+
+    void connection::logged_off() {
+        if (session_ != nullptr) {
+            loop_.sessions().remove(loop_.shard(), session_);
+            session_ = nullptr;
+        }
+
+        logged_off_ = true;
+    }
+
+    bool connection::write(net::gather_list &&frame) {
+        if (evicted_) {
+            return false;
+        }
+
+        if (outbound_.size() + frame.size() > OUTBOUND_QUEUE_LIMIT) {
+            logging::net()->warn("Evicting {0}, too much data queued!", endpoint_.to_string());
+            dump_flight_recorder(spdlog::level::warn, "evicted");
+            evicted_ = true;
+            return false;
+        }
+
+        const auto idle = outbound_.empty();
+        metrics_.queued_bytes.add(static_cast<std::int64_t>(frame.size()));
+
+        if (recorder_ != nullptr) {
+            recorder_->outbound(id_, frame);
+        }
+
+        outbound_.push(std::move(frame));
+
+        // the loop only needs to hear about the first frame of a tick, the rest joins the same flush
+        if (idle) {
+            loop_.schedule_flush(*this);
+        }
+
+        return true;
+    }
+
+    void connection::frame_dispatched(flight_entry &entry) {
+        entry.queued_bytes = static_cast<std::uint32_t>(std::min<std::size_t>(outbound_.size(), UINT32_MAX));
+        flight_.record(entry);
+
+        if (tracer_ == nullptr) {
+            return;
+        }
+
+        const auto now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+
+        tracer_->record({
+                .connection_id = id_,
+                .begin = entry.timestamp,
+                .duration = static_cast<std::uint32_t>(std::min<std::uint64_t>(now - entry.timestamp, UINT32_MAX)),
+                .type = entry.type,
+                .outcome = static_cast<std::uint8_t>(entry.outcome),
+        });
+    }
+
+    void connection::dump_flight_recorder(spdlog::level::level_enum level, std::string_view reason) const {
+        flight_.dump(*logging::net(), level, endpoint_, reason);
+    }
+
+    bool connection::dispatch(net::deserializer &data) {
+        last_activity_ = loop_.timers().now();
+
+        net::protocol::ymsg_header header;
+        net::deserializer body({});
+
+        while (true) {
+            switch (framer_.next(data, header, body)) {
+                case net::protocol::ymsg_framer::result::incomplete:
+                    return socket_.is_valid() && !evicted_;
+                case net::protocol::ymsg_framer::result::invalid:
+                    logging::net()->critical("Invalid packet magic from {0}!", endpoint_.to_string());
+                    dump_flight_recorder(spdlog::level::warn, "invalid magic");
+                    return false;
+                case net::protocol::ymsg_framer::result::frame:
+                    break;
+            }
+
+            const auto frame_body = body.contiguous(wrapped_body_);
+
+            if (recorder_ != nullptr) {
+                recorder_->inbound(id_, header, frame_body);
+            }
+
+            if (!loop_.admission().allow_frame(admission_slot_, last_activity_)) {
+                logging::net()->warn("{0} is sending too fast!", endpoint_.to_string());
+                dump_flight_recorder(spdlog::level::warn, "sending too fast");
+                return false;
+            }
+
+            const net::protocol::ymsg_frame_view fields(frame_body);
+
+            if (!server::handle_frame(*this, header, fields)) {
+                dump_flight_recorder(spdlog::level::warn, "malformed frame");
+                return false;
+            }
+
+            // whatever the client sent after logging off is dropped
+            if (logged_off_) {
+                return false;
+            }
+        }
+    }
+}  // namespace server
@@ -0,0 +1,273 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <capture/recorder.h>
+#include <capture/trace.h>
+
+#include <metrics/metrics.h>
+
+#include <net/gather_list.h>
+#include <net/outbound_queue.h>
+#include <net/packet.h>
+#include <net/ring_buffer.h>
+#include <net/socket.h>
+#include <net/timing_wheel.h>
+
+#include <net/protocol/ymsg/ymsg_framer.h>
+
+#include <server/admission.h>
+#include <server/flight_recorder.h>
+#include <server/session_table.h>
+
+namespace server {
+    struct event_loop;
+
+    /**
+     * @brief How far a client got with its handshake; later stages include the earlier ones.
+     */
+    enum class session_state : std::uint8_t {
+        connected,
+        // sent YES_HELO
+        greeted,
+        // completed YES_USER_LOGIN_2
+        logged_in,
+    };
+
+    struct connection {
+        /**
+         * @brief Constructor.
+         * @param loop The event loop owning the connection.
+         * @param id The ID of the connection, unique within its loop.
+         * @param socket The accepted client socket.
+         * @param endpoint The remote endpoint of the client.
+         */
+        connection(event_loop &loop, std::uint64_t id, net::socket socket, net::endpoint endpoint);
+
+        /**
+         * @brief Destructor; gives the connection back to the admission control of the loop, and ends its session.
+         * @note Only construct connections that admission control admitted.
+         */
+        ~connection();
+
+        connection(const connection &) = delete;
+        connection &operator=(const connection &) = delete;
+
+        /**
+         * @brief Drains the socket and dispatches every frame received so far.
+         * @return true if the connection is still usable, false if it must be closed.
+         */
+        bool on_readable();
+
+        /**
+         * @brief Dispatches every frame completed by data the event loop received on behalf of the connection.
+         * @param data The received data.
+         * @return true if the connection is still usable, false if it must be closed.
+         */
+        bool on_received(std::span<const std::byte> data);
+
+        /**
+         * @brief Handles the expiry of one of the timers of the connection.
+         * @param t The timer.
+         * @return true if the connection is still usable, false if it must be closed.
+         */
+        bool on_timer(net::timer &t);
+
+        /**
+         * @brief Marks the client as greeted, which replaces the HELO deadline with the login deadline.
+         */
+        void greeted();
+
+        /**
+         * @brief Marks the client as logged in, which lifts the login deadline, and creates its session.
+         * @param username The username the client logged in as.
+         * @return The session.
+         */
+        const server::session &logged_in(std::string_view username);
+
+        /**
+         * @brief Ends the session of the client; the connection is closed once the current frame is handled.
+         */
+        void logged_off();
+
+        /**
+         * @brief Gets the session of the client.
+         * @return The session, or nullptr if the client isn't logged in.
+         */
+        const server::session *session() const {
+            return session_;
+        }
+
+        /**
+         * @brief Gets the ID frames to the client are stamped with.
+         * @return The session ID, or 0 if the client isn't logged in.
+         */
+        std::uint32_t session_id() const {
+            return session_ != nullptr ? session_->id : 0;
+        }
+
+        /**
+         * @brief Gets how far the client got with its handshake.
+         * @return The session state.
+         */
+        session_state state() const {
+            return state_;
+        }
+
+        /**
+         * @brief Queues a frame for the client; the owning event loop flushes the queue at the end of its tick.
+         * @note A client whose queue would grow past the hard limit is evicted, and the frame is dropped.
+         * @param frame The segments of the frame.
+         * @return true if the frame was queued, false otherwise.
+         */
+        bool write(net::gather_list &&frame);
+
+        /**
+         * @brief Checks whether the client is too far behind on reading; producers of optional traffic, such as
+         * presence fan-out and chat broadcasts, should hold back until it catches up.
+         * @return true if the outbound queue is congested, false otherwise.
+         */
+        bool congested() const {
+            return outbound_.congested();
+        }
+
+        /**
+         * @brief Checks whether the connection was evicted for not keeping up with its outbound queue.
+         * @return true if the connection must be closed, false otherwise.
+         */
+        bool evicted() const {
+            return evicted_;
+        }
+
+        /**
+         * @brief Gets the frames waiting to be written to the client.
+         * @return The outbound queue.
+         */
+        net::outbound_queue &outbound() {
+            return outbound_;
+        }
+
+        /**
+         * @brief Records a dispatched frame in the flight recorder, and in the trace of the loop if it is traced.
+         * @param entry The frame; the outbound queue depth is filled in.
+         */
+        void frame_dispatched(flight_entry &entry);
+
+        /**
+         * @brief Logs the last frames of the connection.
+         * @param level The level to log at.
+         * @param reason Why the frames are logged.
+         */
+        void dump_flight_recorder(spdlog::level::level_enum level, std::string_view reason) const;
+
+        /**
+         * @brief Gets the event loop owning the connection.
+         * @return The event loop.
+         */
+        event_loop &loop() {
+            return loop_;
+        }
+
+        /**
+         * @brief Gets the metrics of the event loop owning the connection.
+         * @return The metrics shard.
+         */
+        metrics::shard &metrics() {
+            return metrics_;
+        }
+
+        /**
+         * @brief Gets the ID of the connection.
+         * @return The connection ID.
+         */
+        std::uint64_t id() const {
+            return id_;
+        }
+
+        /**
+         * @brief Gets the client socket.
+         * @return The client socket.
+         */
+        net::socket &socket() {
+            return socket_;
+        }
+
+        /**
+         * @brief Gets the remote endpoint of the client.
+         * @return The remote endpoint.
+         */
+        const net::endpoint &endpoint() const {
+            return endpoint_;
+        }
+
+    private:
+        /**
+         * @brief Dispatches every frame completed by the data.
+         * @param data The received data; advanced past everything the framer consumed.
+         * @return true if the connection is still usable, false if it must be closed.
+         */
+        bool dispatch(net::deserializer &data);
+
+        /**
+         * @brief Checks the bytes buffered for an incomplete frame against the limit for the stage of the client.
+         * @return true if the connection is still usable, false if it must be closed.
+         */
+        bool check_pending() const;
+
+        event_loop &loop_;
+        metrics::shard &metrics_;
+
+        // nullptr unless the traffic of the loop is recorded, or its frames traced
+        capture::recorder *recorder_;
+        capture::tracer *tracer_;
+
+        std::uint64_t id_;
+        net::socket socket_;
+        net::endpoint endpoint_;
+        net::ring_buffer buffer_;
+        net::protocol::ymsg_framer framer_;
+
+        // frame bodies that wrap around the end of the receive buffer are copied in here to be parsed
+        std::vector<std::byte> wrapped_body_;
+        net::outbound_queue outbound_;
+        bool evicted_ = false;
+        bool logged_off_ = false;
+        session_state state_ = session_state::connected;
+        const server::session *session_ = nullptr;
+        flight_recorder flight_;
+
+        admission_control::slot admission_slot_;
+
+        // tick of the last read; the liveness timer is only moved when it fires, so that reads stay cheap
+        std::uint64_t last_activity_;
+        net::timer liveness_timer_{this};
+        net::timer login_timer_{this};
+    };
+}  // namespace server
@@ -0,0 +1,282 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <server/epoll_loop.h>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <utility>
+
+#include <logging/logging.h>
+
+namespace server {
+    // how long a single poll may block; one timer tick, so that timers and stop() are handled in time without having
+    // to wake the loop up
+    constexpr auto POLL_TIMEOUT_MS = static_cast<std::int32_t>(TIMER_TICK.count());
+
+    epoll_loop::epoll_loop(std::uint32_t shard, session_table &sessions, message_router &router,
+                           net::socket listener)
+      : event_loop(shard, sessions, router), listener_(std::move(listener)) {}
+
+    bool epoll_loop::run() {
+        if (!poller_.is_valid() || !listener_.set_non_blocking()) {
+            logging::net()->error("Failed to set up the event loop!");
+            return false;
+        }
+
+        // the listener is tagged with a null pointer, the mailbox with itself, every other socket with its client
+        if (!poller_.add(listener_.get(), net::poller::readable, nullptr)) {
+            logging::net()->error("Failed to watch the listening socket!");
+            return false;
+        }
+
+        auto &mailbox = router().mailbox_of(shard());
+
+        // without a wake handle, the mailbox is only drained at the end of every tick
+        if (mailbox.wake_handle() != -1 && !poller_.add(mailbox.wake_handle(), net::poller::readable, &mailbox)) {
+            logging::net()->error("Failed to watch the mailbox!");
+            return false;
+        }
+
+        std::array<net::poller::event, 256> events{};
+        running_ = true;
+
+        while (running_) {
+            const auto count = poller_.wait(events, POLL_TIMEOUT_MS);
+            if (count < 0) {
+                if (net::impl::interrupted()) {
+                    continue;
+                }
+
+                logging::net()->critical("Polling failed!");
+                return false;
+            }
+
+            for (std::int32_t i = 0; i < count; i++) {
+                const auto &event = events[i];
+
+                if (event.data == nullptr) {
+                    accept_connections();
+                    continue;
+                }
+
+                if (event.data == &mailbox) {
+                    mailbox.clear_wake();
+                    continue;
+                }
+
+                auto &c = *static_cast<client *>(event.data);
+
+                if ((event.events & (net::poller::hangup | net::poller::error)) &&
+                    !(event.events & net::poller::readable)) {
+                    close_connection(c);
+                    continue;
+                }
+
+                if ((event.events & net::poller::readable) && !c.conn->on_readable()) {
+                    close_connection(c);
+                    continue;
+                }
+
+                if ((event.events & net::poller::writable) && !flush(c)) {
+                    close_connection(c);
+                }
+            }
+
+            timers().advance(current_tick(), [this](net::timer &t) {
+                auto &conn = *static_cast<connection *>(t.data());
+                if (!conn.on_timer(t)) {
+                    close_connection(clients_.at(conn.socket().get()));
+                }
+            });
+
+            if (accept_stalled_) {
+                accept_connections();
+            }
+
+            // frames from other loops join the same flush
+            drain_mailbox();
+
+            // everything queued during the tick goes out in as few writes as possible
+            flush_dirty();
+
+            if (!congested_.empty()) {
+                evict_congested();
+            }
+
+            if (take_dump_request()) {
+                for (const auto &[handle, c] : clients_) {
+                    c.conn->dump_flight_recorder(spdlog::level::info, "requested");
+                }
+            }
+
+            flush_captures();
+
+            // no session found during the tick is held past this point
+            sessions().quiescent(shard());
+        }
+
+        return true;
+    }
+
+    void epoll_loop::accept_connections() {
+        // edge triggered, so keep accepting until the backlog is empty
+        std::optional<std::pair<net::socket, net::endpoint>> client;
+        net::socket::accept_status status;
+
+        while ((status = listener_.accept(client)) == net::socket::accept_status::accepted) {
+            auto &[socket, endpoint] = client.value();
+            const auto handle = socket.get();
+
+            // refused sockets are closed right away; not logged, as that is exactly what a flood would want
+            if (!admission().admit(admission().find(endpoint), timers().now())) {
+                continue;
+            }
+
+            auto &c = clients_[handle];
+            c.conn = std::make_unique<connection>(*this, next_connection_id(), std::move(socket), endpoint);
+
+            if (!poller_.add(handle, net::poller::readable, &c)) {
+                logging::net()->error("Failed to watch connection from {0}!", endpoint.to_string());
+                clients_.erase(handle);
+                continue;
+            }
+
+            logging::net()->info("New connection received from {0}!", endpoint.to_string());
+        }
+
+        // logged once per stall rather than on every retry
+        const auto stalled = status == net::socket::accept_status::failed;
+        if (stalled && !accept_stalled_) {
+            logging::net()->error("Failed to accept connections, retrying every tick!");
+        }
+
+        accept_stalled_ = stalled;
+    }
+
+    void epoll_loop::schedule_flush(connection &conn) {
+        const auto it = clients_.find(conn.socket().get());
+        if (it == clients_.end() || it->second.dirty) {
+            return;
+        }
+
+        it->second.dirty = true;
+        dirty_.push_back(it->first);
+    }
+
+    bool epoll_loop::flush(client &c) {
+        auto &outbound = c.conn->outbound();
+        const auto handle = c.conn->socket().get();
+
+        while (!outbound.empty()) {
+            if (const auto sent = outbound.send(c.conn->socket()); sent > 0) {
+                metrics().bytes_sent.add(sent);
+                metrics().queued_bytes.add(-sent);
+                continue;
+            }
+
+            if (net::impl::interrupted()) {
+                continue;
+            }
+
+            if (!net::impl::would_block()) {
+                return false;
+            }
+
+            // the client is behind, pick up again once its socket drains
+            if (!c.waiting_writable) {
+                c.waiting_writable = poller_.modify(handle, net::poller::readable | net::poller::writable, &c);
+                if (!c.waiting_writable) {
+                    return false;
+                }
+            }
+
+            if (outbound.congested() && c.congested_since == std::chrono::steady_clock::time_point{}) {
+                c.congested_since = std::chrono::steady_clock::now();
+                congested_.push_back(handle);
+            }
+
+            return true;
+        }
+
+        if (c.waiting_writable) {
+            c.waiting_writable = !poller_.modify(handle, net::poller::readable, &c);
+        }
+
+        return true;
+    }
+
+    void epoll_loop::flush_dirty() {
+        for (const auto handle: dirty_) {
+            const auto it = clients_.find(handle);
+            if (it == clients_.end()) {
+                continue;
+            }
+
+            auto &c = it->second;
+            c.dirty = false;
+
+            if (c.conn->evicted() || !flush(c)) {
+                close_connection(c);
+            }
+        }
+
+        dirty_.clear();
+    }
+
+    void epoll_loop::evict_congested() {
+        const auto now = std::chrono::steady_clock::now();
+
+        std::erase_if(congested_, [this, now](net::socket_type handle) {
+            const auto it = clients_.find(handle);
+            if (it == clients_.end() || it->second.congested_since == std::chrono::steady_clock::time_point{}) {
+                return true;
+            }
+
+            auto &c = it->second;
+
+            if (!c.conn->congested()) {
+                c.congested_since = {};
+                return true;
+            }
+
+            if (now - c.congested_since < MAX_CONGESTION_TIME) {
+                return false;
+            }
+
+            logging::net()->warn("Evicting {0}, congested for too long!", c.conn->endpoint().to_string());
+            close_connection(c);
+            return true;
+        });
+    }
+
+    void epoll_loop::close_connection(client &c) {
+        logging::net()->info("Connection from {0} lost!", c.conn->endpoint().to_string());
+
+        const auto handle = c.conn->socket().get();
+        poller_.remove(handle);
+
+        // destroys the connection and closes its socket
+        clients_.erase(handle);
+    }
+}  // namespace server
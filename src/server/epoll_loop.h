@@ -0,0 +1,92 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <net/poller.h>
+#include <net/socket.h>
+
+#include <server/connection.h>
+#include <server/event_loop.h>
+
+namespace server {
+    /**
+     * @brief Readiness based event loop; edge-triggered epoll on Linux, WSAPoll elsewhere.
+     */
+    struct epoll_loop : event_loop {
+        /**
+         * @brief Constructor.
+         * @param shard Index of the loop among the loops of the server.
+         * @param sessions The session table shared by every loop of the server.
+         * @param router The mailboxes of every loop of the server.
+         * @param listener A bound, listening socket. The loop switches it to non-blocking mode.
+         */
+        epoll_loop(std::uint32_t shard, session_table &sessions, message_router &router, net::socket listener);
+
+        bool run() override;
+
+        void schedule_flush(connection &conn) override;
+
+    private:
+        struct client {
+            std::unique_ptr<connection> conn;
+
+            // set while the socket is also watched for writability, because the last flush would have blocked
+            bool waiting_writable = false;
+            bool dirty = false;
+
+            // when the outbound queue was first seen congested, if it still is
+            std::chrono::steady_clock::time_point congested_since{};
+        };
+
+        void accept_connections();
+
+        /**
+         * @brief Writes as much of the outbound queue of a client as the socket takes.
+         * @param c The client.
+         * @return true if the client is still usable, false if it must be closed.
+         */
+        bool flush(client &c);
+
+        void flush_dirty();
+
+        void evict_congested();
+
+        void close_connection(client &c);
+
+        net::poller poller_;
+        net::socket listener_;
+        std::unordered_map<net::socket_type, client> clients_;
+        std::vector<net::socket_type> dirty_;
+        std::vector<net::socket_type> congested_;
+
+        // set while the listener can't accept, e.g. out of file descriptors; retried every tick, since the
+        // edge-triggered listener won't report the connections already queued again
+        bool accept_stalled_ = false;
+    };
+}  // namespace server
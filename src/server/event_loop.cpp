@@ -0,0 +1,96 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <server/event_loop.h>
+#include <server/epoll_loop.h>
+#include <server/uring_loop.h>
+#include <server/connection.h>
+#include <server/replies.h>
+
+#include <logging/logging.h>
+
+namespace server {
+    std::unique_ptr<event_loop> event_loop::create(io_backend backend, std::uint32_t shard, session_table &sessions,
+                                                   message_router &router, net::socket listener) {
+        switch (backend) {
+            case io_backend::epoll:
+                return std::make_unique<epoll_loop>(shard, sessions, router, std::move(listener));
+#ifdef __linux__
+            case io_backend::io_uring:
+                return std::make_unique<uring_loop>(shard, sessions, router, std::move(listener));
+#endif
+            default:
+                return nullptr;
+        }
+    }
+
+    bool event_loop::route(const session &target, routed_message &&message) {
+        if (target.shard == shard_) {
+            deliver(std::move(message));
+            return true;
+        }
+
+        return router_.post(target.shard, std::move(message));
+    }
+
+    void event_loop::drain_mailbox() {
+        auto &mailbox = router_.mailbox_of(shard_);
+        metrics_.mailbox_depth.set(static_cast<std::int64_t>(mailbox.size()));
+
+        mailbox.drain([this](routed_message &&message) {
+            deliver(std::move(message));
+        });
+    }
+
+    void event_loop::deliver(routed_message &&message) {
+        if (const auto *target = sessions_.find(message.target_session)) {
+            // an evicted connection is closed by the loop when it is flushed
+            if (!target->conn->write(std::move(message.frame))) {
+                schedule_flush(*target->conn);
+            }
+
+            return;
+        }
+
+        // the target went away after the frame was routed to it; the origin is told, wherever it is now
+        const auto *origin = message.origin_session != 0 ? sessions_.find(message.origin_session) : nullptr;
+
+        if (origin == nullptr) {
+            return;
+        }
+
+        routed_message bounce{
+                .target_session = origin->id,
+                .origin_session = 0,
+                .type = message.type,
+                .target = origin->username,
+                .frame = replies::message_not_delivered(message.type, net::protocol::YES_STATUS_INVALID_USER,
+                                                        origin->id, message.target),
+        };
+
+        if (!route(*origin, std::move(bounce))) {
+            SPDLOG_LOGGER_DEBUG(logging::server(), "Mailbox of thread {0} is full, dropped a bounce for {1}!",
+                                origin->shard, origin->username);
+        }
+    }
+}  // namespace server
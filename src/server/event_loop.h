@@ -0,0 +1,294 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include <capture/recorder.h>
+#include <capture/trace.h>
+
+#include <metrics/metrics.h>
+
+#include <net/socket.h>
+#include <net/timing_wheel.h>
+
+#include <server/admission.h>
+#include <server/router.h>
+#include <server/session_table.h>
+
+namespace server {
+    struct connection;
+
+    enum class io_backend : std::uint8_t {
+        epoll,
+        io_uring,
+    };
+
+    // connection IDs carry the shard of their loop above this bit
+    constexpr std::uint32_t CONNECTION_ID_SHARD_SHIFT = 48;
+
+    // how long a client may stay above the high watermark of its outbound queue before it is evicted
+    constexpr std::chrono::seconds MAX_CONGESTION_TIME{30};
+
+    // resolution of connection timers; loops never block for longer than this
+    constexpr std::chrono::milliseconds TIMER_TICK{100};
+
+    /**
+     * @brief Single threaded reactor owning a listening socket and every connection accepted from it.
+     */
+    struct event_loop {
+        virtual ~event_loop() = default;
+
+        /**
+         * @brief Creates an event loop driven by the given I/O backend.
+         * @param backend The I/O backend.
+         * @param shard Index of the loop among the loops of the server.
+         * @param sessions The session table shared by every loop of the server; must outlive the loop.
+         * @param router The mailboxes of every loop of the server; must outlive the loop.
+         * @param listener A bound, listening socket.
+         * @return The event loop, or nullptr if the backend is not available on this system.
+         */
+        static std::unique_ptr<event_loop> create(io_backend backend, std::uint32_t shard, session_table &sessions,
+                                                  message_router &router, net::socket listener);
+
+        /**
+         * @brief Runs the loop until stop() is called.
+         * @return true if the loop exited cleanly, false if it failed to start or to poll.
+         */
+        virtual bool run() = 0;
+
+        /**
+         * @brief Asks the loop to write the outbound queue of a connection it owns at the end of the current tick.
+         * @param conn The connection.
+         */
+        virtual void schedule_flush(connection &conn) = 0;
+
+        /**
+         * @brief Asks the loop to exit.
+         * @note Safe to call from any thread and from signal handlers.
+         */
+        void stop() {
+            running_ = false;
+        }
+
+        /**
+         * @brief Gets the sessions of every loop of the server.
+         * @return The session table.
+         */
+        session_table &sessions() {
+            return sessions_;
+        }
+
+        /**
+         * @brief Gets the mailboxes of every loop of the server.
+         * @return The router.
+         */
+        message_router &router() {
+            return router_;
+        }
+
+        /**
+         * @brief Hands a frame to a session: right away if the session belongs to this loop, through the mailbox of
+         * its loop otherwise.
+         * @note If the session is gone by the time the frame arrives, the origin of the message is told.
+         * @param target The session, as found in the session table during the current tick.
+         * @param message The frame, addressed to the session.
+         * @return true if the frame was delivered or posted, false if the mailbox of the other loop is full.
+         */
+        bool route(const session &target, routed_message &&message);
+
+        /**
+         * @brief Lets every login through without checking credentials, for development and load testing.
+         * @note Call before run().
+         * @param enabled Whether logins are let through.
+         */
+        void set_dev_login(bool enabled) {
+            dev_login_ = enabled;
+        }
+
+        /**
+         * @brief Checks whether every login is let through without checking credentials.
+         * @return true if logins aren't checked, false otherwise.
+         */
+        bool dev_login() const {
+            return dev_login_;
+        }
+
+        /**
+         * @brief Gets the per source address limits of the connections owned by this loop.
+         * @return The admission control table.
+         */
+        admission_control &admission() {
+            return admission_;
+        }
+
+        /**
+         * @brief Gets the timers of the connections owned by this loop.
+         * @return The timing wheel, counting in TIMER_TICK units.
+         */
+        net::timing_wheel &timers() {
+            return timers_;
+        }
+
+        /**
+         * @brief Records the traffic of every connection the loop accepts from now on.
+         * @note Call before run().
+         * @param recorder The recorder, or nullptr to stop recording.
+         */
+        void set_recorder(std::unique_ptr<capture::recorder> recorder) {
+            recorder_ = std::move(recorder);
+        }
+
+        /**
+         * @brief Gets the recorder of the loop.
+         * @return The recorder, or nullptr if the traffic isn't recorded.
+         */
+        capture::recorder *recorder() {
+            return recorder_.get();
+        }
+
+        /**
+         * @brief Traces the dispatch of every frame of the connections the loop accepts from now on.
+         * @note Call before run().
+         * @param tracer The tracer, or nullptr to stop tracing.
+         */
+        void set_tracer(std::unique_ptr<capture::tracer> tracer) {
+            tracer_ = std::move(tracer);
+        }
+
+        /**
+         * @brief Gets the tracer of the loop.
+         * @return The tracer, or nullptr if frames aren't traced.
+         */
+        capture::tracer *tracer() {
+            return tracer_.get();
+        }
+
+        /**
+         * @brief Asks the loop to log the flight recorders of all of its connections at the end of the current tick.
+         * @note Safe to call from any thread and from signal handlers.
+         */
+        void request_dump() {
+            dump_requested_ = true;
+        }
+
+        /**
+         * @brief Gets the metrics of the loop.
+         * @return The metrics shard, written only from the thread of the loop.
+         */
+        metrics::shard &metrics() {
+            return metrics_;
+        }
+
+        /**
+         * @brief Gets the index of the loop among the loops of the server.
+         * @return The shard index.
+         */
+        std::uint32_t shard() const {
+            return shard_;
+        }
+
+    protected:
+        /**
+         * @brief Constructor.
+         * @param shard Index of the loop among the loops of the server.
+         * @param sessions The session table shared by every loop of the server.
+         * @param router The mailboxes of every loop of the server.
+         */
+        event_loop(std::uint32_t shard, session_table &sessions, message_router &router)
+          : shard_(shard), sessions_(sessions), router_(router), epoch_(std::chrono::steady_clock::now()) {}
+
+        /**
+         * @brief Delivers the frames other loops posted to this one.
+         */
+        void drain_mailbox();
+
+        /**
+         * @brief Gets the tick the timers of the loop should be advanced to.
+         * @return The number of TIMER_TICK periods since the loop was created.
+         */
+        std::uint64_t current_tick() const {
+            return (std::chrono::steady_clock::now() - epoch_) / TIMER_TICK;
+        }
+
+        /**
+         * @brief Hands out IDs for new connections of this loop.
+         * @note The shard index is kept in the upper 16 bits, so IDs are unique across the whole server.
+         * @return A new connection ID.
+         */
+        std::uint64_t next_connection_id() {
+            return (static_cast<std::uint64_t>(shard_) << CONNECTION_ID_SHARD_SHIFT) | ++last_connection_id_;
+        }
+
+        /**
+         * @brief Takes a request made with request_dump().
+         * @return true if the flight recorders must be logged, false otherwise.
+         */
+        bool take_dump_request() {
+            return dump_requested_.exchange(false, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Flushes the capture and trace files once they are due; called every tick, as the files are
+         * otherwise only flushed when the next record is written.
+         */
+        void flush_captures() {
+            if (recorder_ != nullptr) {
+                recorder_->flush_if_due();
+            }
+
+            if (tracer_ != nullptr) {
+                tracer_->flush_if_due();
+            }
+        }
+
+        std::atomic<bool> running_{false};
+
+    private:
+        /**
+         * @brief Writes a frame to a session of this loop, or tells the origin if the session is gone.
+         * @param message The frame.
+         */
+        void deliver(routed_message &&message);
+
+        std::uint32_t shard_;
+        std::uint64_t last_connection_id_ = 0;
+        session_table &sessions_;
+        message_router &router_;
+        bool dev_login_ = false;
+
+        std::chrono::steady_clock::time_point epoch_;
+        net::timing_wheel timers_;
+        admission_control admission_;
+        metrics::shard metrics_;
+        std::unique_ptr<capture::recorder> recorder_;
+        std::unique_ptr<capture::tracer> tracer_;
+        std::atomic<bool> dump_requested_{false};
+    };
+}  // namespace server
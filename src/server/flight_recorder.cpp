@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <server/flight_recorder.h>
+
+#include <algorithm>
+
+namespace server {
+    void flight_recorder::dump(spdlog::logger &logger, spdlog::level::level_enum level, const net::endpoint &endpoint,
+                               std::string_view reason) const {
+        if (!logger.should_log(level)) {
+            return;
+        }
+
+        const auto kept = std::min<std::uint64_t>(recorded_, DEPTH);
+        logger.log(level, "Last {0} of {1} frames from {2} ({3}):", kept, recorded_, endpoint.to_string(), reason);
+
+        const auto first = recorded_ - kept;
+        const auto last_timestamp = kept != 0 ? entries_[(recorded_ - 1) % DEPTH].timestamp : 0;
+
+        for (auto i = first; i < recorded_; i++) {
+            const auto &e = entries_[i % DEPTH];
+
+            // times are relative to the last frame, which is usually the interesting one
+            const auto age_us = static_cast<double>(last_timestamp - e.timestamp) / 1e3;
+
+            if (e.fields == flight_entry::FIELDS_NOT_COUNTED) {
+                logger.log(level, "  #{0} -{1:.1f}us type {2} status {3} session {4:#x} length {5}, {6}, "
+                                  "handler {7:.1f}us, {8} bytes queued",
+                           i, age_us, e.type, e.status, e.session_id, e.length, to_string(e.outcome),
+                           e.handler_time / 1e3, e.queued_bytes);
+            } else {
+                logger.log(level, "  #{0} -{1:.1f}us type {2} status {3} session {4:#x} length {5}, {6} fields, {7}, "
+                                  "handler {8:.1f}us, {9} bytes queued",
+                           i, age_us, e.type, e.status, e.session_id, e.length, e.fields, to_string(e.outcome),
+                           e.handler_time / 1e3, e.queued_bytes);
+            }
+        }
+    }
+}  // namespace server
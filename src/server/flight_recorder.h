@@ -0,0 +1,122 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include <spdlog/logger.h>
+
+#include <net/socket.h>
+
+namespace server {
+    /**
+     * @brief What became of a frame received from a client.
+     */
+    enum class frame_outcome : std::uint8_t {
+        handled,
+        // no handler for the type; answered with YES_FEATURE_NOT_SUPPORTED
+        unknown_type,
+        // the client hadn't got far enough with its handshake
+        too_early,
+        // a field couldn't be parsed; the connection is closed
+        malformed,
+    };
+
+    constexpr std::string_view to_string(frame_outcome outcome) {
+        switch (outcome) {
+            case frame_outcome::handled:
+                return "handled";
+            case frame_outcome::unknown_type:
+                return "unknown type";
+            case frame_outcome::too_early:
+                return "too early";
+            case frame_outcome::malformed:
+                return "malformed";
+        }
+
+        return "?";
+    }
+
+    /**
+     * @brief One frame as the flight recorder keeps it.
+     */
+    struct flight_entry {
+        // steady clock time the frame was dispatched at, in nanoseconds
+        std::uint64_t timestamp = 0;
+
+        std::uint32_t session_id = 0;
+        std::int32_t status = 0;
+
+        // time spent in the handler, in nanoseconds
+        std::uint32_t handler_time = 0;
+
+        // bytes in the outbound queue once the frame was handled
+        std::uint32_t queued_bytes = 0;
+
+        std::uint16_t type = 0;
+        std::uint16_t length = 0;
+
+        // FIELDS_NOT_COUNTED for frames whose fields weren't decoded
+        std::uint16_t fields = 0;
+        frame_outcome outcome = frame_outcome::handled;
+
+        constexpr static std::uint16_t FIELDS_NOT_COUNTED = 0xFFFF;
+    };
+
+    static_assert(sizeof(flight_entry) == 32);
+
+    /**
+     * @brief Keeps the last few frames of a connection, to be logged when something goes wrong with it.
+     * @note Recording is a copy into a fixed ring, so it can stay on for every connection.
+     */
+    struct flight_recorder {
+        // frames kept
+        constexpr static std::size_t DEPTH = 16;
+
+        /**
+         * @brief Records a frame, replacing the oldest if the ring is full.
+         * @param entry The frame.
+         */
+        void record(const flight_entry &entry) {
+            entries_[recorded_++ % DEPTH] = entry;
+        }
+
+        /**
+         * @brief Logs the frames kept, oldest first.
+         * @param logger The logger to log to.
+         * @param level The level to log at.
+         * @param endpoint The remote endpoint of the connection.
+         * @param reason Why the frames are logged.
+         */
+        void dump(spdlog::logger &logger, spdlog::level::level_enum level, const net::endpoint &endpoint,
+                  std::string_view reason) const;
+
+    private:
+        std::array<flight_entry, DEPTH> entries_{};
+        std::uint64_t recorded_ = 0;
+    };
+}  // namespace server
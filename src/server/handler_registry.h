@@ -0,0 +1,104 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <optional>
+
+#include <server/connection.h>
+
+#include <net/protocol/ymsg/enums/ymsg_message_type.hpp>
+#include <net/protocol/ymsg/ymsg_field_view.h>
+#include <net/protocol/ymsg/ymsg_header.h>
+
+namespace server {
+    /**
+     * @brief What a handler found out about the fields of the frame it handled.
+     */
+    struct handler_result {
+        // fields walked while decoding the frame, or nothing if the handler didn't look at them
+        std::optional<std::size_t> fields;
+
+        // the body isn't made of well-formed fields; the connection is closed
+        bool malformed = false;
+    };
+
+    using handler_function = handler_result (*)(connection &conn, const net::protocol::ymsg_header &header,
+                                                const net::protocol::ymsg_frame_view &fields);
+
+    /**
+     * @brief A handler and what it expects of the frames routed to it.
+     */
+    struct handler_entry {
+        handler_function handler = nullptr;
+
+        // frames from clients that haven't got this far yet are dropped
+        session_state required_state = session_state::connected;
+
+        // the handler does enough work to be worth moving off the event loop thread
+        bool cpu_heavy = false;
+    };
+
+    /**
+     * @brief Maps every message type to its handler through one array indexed by type, so dispatching costs the
+     * same however many handlers there are.
+     */
+    struct handler_registry {
+        // one past the largest YES_ value
+        constexpr static std::size_t TYPE_COUNT = net::protocol::YES_LWMOPI_STOPOPI + 1;
+
+        struct registration {
+            net::protocol::YES_ type;
+            handler_entry entry;
+        };
+
+        /**
+         * @brief Constructor.
+         * @param registrations The handlers, with the types they handle.
+         */
+        constexpr handler_registry(std::initializer_list<registration> registrations) {
+            for (const auto &r: registrations) {
+                entries_[r.type] = r.entry;
+            }
+        }
+
+        /**
+         * @brief Finds the handler of a message type.
+         * @param type The message type.
+         * @return The entry of the handler, or nullptr if the type has none.
+         */
+        constexpr const handler_entry *find(net::protocol::YES_ type) const {
+            if (type >= TYPE_COUNT || entries_[type].handler == nullptr) {
+                return nullptr;
+            }
+
+            return &entries_[type];
+        }
+
+    private:
+        std::array<handler_entry, TYPE_COUNT> entries_{};
+    };
+}  // namespace server
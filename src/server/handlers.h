@@ -22,19 +22,39 @@
 
 #pragma once
 
-#include <net/socket.h>
+#include <server/connection.h>
+#include <server/handler_registry.h>
+#include <server/messages.h>
+#include <server/replies.h>
 #include <net/protocol/ymsg/ymsg_header.h>
 #include <net/protocol/ymsg/ymsg_field.h>
+#include <net/protocol/ymsg/ymsg_field_view.h>
+#include <net/protocol/ymsg/ymsg_frame_builder.h>
 
 using namespace net::protocol;
 
 namespace server {
     namespace handlers {
-        void handle_helo(net::socket &sock, const net::protocol::ymsg_header &header,
-                         const std::vector<net::protocol::ymsg_field> &fields);
-        void handle_port_check(net::socket &sock, const net::protocol::ymsg_header &header,
-                         const std::vector<net::protocol::ymsg_field> &fields);
-        void handle_login_stage2(net::socket &sock, const net::protocol::ymsg_header &header,
-                         const std::vector<net::protocol::ymsg_field> &fields);
+        /**
+         * @brief Reports a schema extraction back to the dispatcher.
+         * @param result The result of the extraction.
+         * @return The number of fields walked, and whether the frame turned out malformed.
+         */
+        inline handler_result decoded(const net::protocol::ymsg_schema_result &result) {
+            return {result.fields, result.status == net::protocol::ymsg_schema_status::malformed_frame};
+        }
+
+        handler_result handle_helo(connection &conn, const net::protocol::ymsg_header &header,
+                                   const net::protocol::ymsg_frame_view &fields);
+        handler_result handle_port_check(connection &conn, const net::protocol::ymsg_header &header,
+                                         const net::protocol::ymsg_frame_view &fields);
+        handler_result handle_login_stage2(connection &conn, const net::protocol::ymsg_header &header,
+                                           const net::protocol::ymsg_frame_view &fields);
+        handler_result handle_message(connection &conn, const net::protocol::ymsg_header &header,
+                                      const net::protocol::ymsg_frame_view &fields);
+        handler_result handle_logoff(connection &conn, const net::protocol::ymsg_header &header,
+                                     const net::protocol::ymsg_frame_view &fields);
+        handler_result handle_keep_alive(connection &conn, const net::protocol::ymsg_header &header,
+                                         const net::protocol::ymsg_frame_view &fields);
     }
 }
\ No newline at end of file
@@ -22,39 +22,24 @@
 
 #include <server/handlers.h>
 
-#include <spdlog/spdlog.h>
+#include <logging/logging.h>
 
 namespace server {
     namespace handlers {
-        void handle_helo(net::socket &sock, const net::protocol::ymsg_header &header,
-                         const std::vector<net::protocol::ymsg_field> &fields) {
-            spdlog::get("server")->debug("Received HELO!");
+        handler_result handle_helo(connection &conn, const net::protocol::ymsg_header & /*header*/,
+                                   const net::protocol::ymsg_frame_view &fields) {
+            SPDLOG_LOGGER_DEBUG(logging::server(), "Received HELO!");
 
-            std::string username;
+            messages::helo request;
+            const auto result = messages::helo_schema::parse(fields, request);
 
-            for(const auto& field : fields) {
-                if(field.key == YMSG_FLD_CURRENT_ID) {
-                    username = field.value;
-                    break;
-                }
+            if (result.status == ymsg_schema_status::malformed_frame) {
+                return decoded(result);
             }
 
-            net::serializer response_fields;
-            response_fields.emplace<net::protocol::ymsg_field>(YMSG_FLD_CURRENT_ID, username);
-            response_fields.emplace<net::protocol::ymsg_field>(YMSG_FLD_FLAG, "2");
-            response_fields.emplace<net::protocol::ymsg_field>(YMSG_FLD_CHALLENGE, "CHALLENGE-123");
-
-            // ToDo: make YMSGClient class to handle proper sending
-            net::serializer response;
-            response.emplace<net::protocol::ymsg_header>(16,
-                                                  0,
-                                                  response_fields.size(),
-                                                  YES_HELO,
-                                                  YES_STATUS_NOTIFY,
-                                                  0);
-            response.serialize(response_fields.data().data(), response_fields.size());
-
-            sock.write(response);
+            conn.greeted();
+            conn.write(replies::helo().instantiate(0, request.username, "CHALLENGE-123"));
+            return decoded(result);
         }
     }
 }
\ No newline at end of file
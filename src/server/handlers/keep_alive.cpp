@@ -0,0 +1,37 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <server/handlers.h>
+
+#include <logging/logging.h>
+
+namespace server {
+    namespace handlers {
+        handler_result handle_keep_alive([[maybe_unused]] connection &conn,
+                                         const net::protocol::ymsg_header & /*header*/,
+                                         const net::protocol::ymsg_frame_view & /*fields*/) {
+            // receiving the frame already counts as activity, there is nothing to answer
+            SPDLOG_LOGGER_DEBUG(logging::server(), "Keep alive from {0}!", conn.endpoint().to_string());
+            return {};
+        }
+    }
+}
\ No newline at end of file
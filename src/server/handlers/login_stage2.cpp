@@ -21,53 +21,44 @@
 // SOFTWARE.
 
 #include <server/handlers.h>
+#include <server/event_loop.h>
 
-#include <spdlog/spdlog.h>
+#include <logging/logging.h>
 
 namespace server {
     namespace handlers {
-        void handle_login_stage2(net::socket &sock, const net::protocol::ymsg_header &header,
-                                 const std::vector<net::protocol::ymsg_field> &fields) {
-            std::string username{};
-            std::string cookie_y{};
-            std::string cookie_t{};
-            std::string crumb_hash{};
-            std::string client_country_code{"unknown"};
-            std::string client_version{"unknown"};
+        handler_result handle_login_stage2(connection &conn, const net::protocol::ymsg_header & /*header*/,
+                                           const net::protocol::ymsg_frame_view &fields) {
+            messages::login_stage2 request;
+            const auto result = messages::login_stage2_schema::parse(fields, request);
 
-            for (const auto &field: fields) {
-                if (field.key == YMSG_FLD_CURRENT_ID) {
-                    username = field.value;
-                } else if (field.key == YMSG_FLD_LOGIN_Y_COOKIE) {
-                    cookie_y = field.value;
-                } else if (field.key == YMSG_FLD_LOGIN_T_COOKIE) {
-                    cookie_t = field.value;
-                } else if (field.key == YMSG_FLD_CRUMB_HASH) {
-                    crumb_hash = field.value;
-                } else if (field.key == YMSG_FLD_COUNTRY_CODE) {
-                    client_country_code = field.value;
-                } else if (field.key == YMSG_FLD_VERSION) {
-                    client_version = field.value;
-                }
+            if (result.status == ymsg_schema_status::malformed_frame) {
+                return decoded(result);
             }
 
-            spdlog::get("server")->debug("{0} is connecting from Y!M {1} ({2})", username.data(),
-                                         client_version.data(), client_country_code.data());
+            if (!result) {
+                logging::server()->warn("Bad login request from {0}, field {1} is missing or malformed!",
+                                        conn.endpoint().to_string(), (int) result.key);
+                conn.write(replies::login_failed().instantiate(0, 3));
+                return decoded(result);
+            }
+
+            SPDLOG_LOGGER_DEBUG(logging::server(), "{0} is connecting from Y!M {1} ({2})", request.username,
+                                request.version, request.country_code);
 
-            net::serializer response_fields;
-            response_fields.emplace<net::protocol::ymsg_field>(YMSG_FLD_ERROR_CODE, "3");
+            // ToDo: check the credentials
+            if (!conn.loop().dev_login()) {
+                conn.write(replies::login_failed().instantiate(0, 3));
+                return decoded(result);
+            }
 
-            // ToDo: fail login
-            net::serializer response;
-            response.emplace<net::protocol::ymsg_header>(16,
-                                                         0,
-                                                         response_fields.size(),
-                                                         YES_USER_LOGIN_2,
-                                                         YES_STATUS_ERR,
-                                                         0);
-            response.serialize(response_fields.data().data(), response_fields.size());
+            const auto &session = conn.logged_in(request.username);
+            logging::server()->info("{0} logged in from {1}, session {2:#x}!", session.username,
+                                    conn.endpoint().to_string(), session.id);
 
-            sock.write(response);
+            conn.write(replies::login_succeeded().instantiate(session.id, std::string_view(session.username),
+                                                              std::string_view(session.username)));
+            return decoded(result);
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <server/handlers.h>
+#include <server/event_loop.h>
+
+#include <chrono>
+
+#include <logging/logging.h>
+
+namespace server {
+    namespace handlers {
+        handler_result handle_message(connection &conn, const net::protocol::ymsg_header &header,
+                                      const net::protocol::ymsg_frame_view &fields) {
+            messages::instant_message request;
+            const auto result = messages::instant_message_schema::parse(fields, request);
+
+            if (result.status == ymsg_schema_status::malformed_frame) {
+                return decoded(result);
+            }
+
+            if (!result) {
+                logging::server()->warn("Bad message from {0}, field {1} is missing or malformed!",
+                                        conn.endpoint().to_string(), (int) result.key);
+                return decoded(result);
+            }
+
+            auto &loop = conn.loop();
+            const auto &sender = *conn.session();
+            const auto *target = loop.sessions().find(request.target);
+
+            // ToDo: keep messages to users who are offline, and answer YES_STATUS_SAVED_MESG
+            if (target == nullptr) {
+                conn.write(replies::message_not_delivered(header.type, YES_STATUS_INVALID_USER, sender.id,
+                                                          request.target));
+                return decoded(result);
+            }
+
+            // encoded here, so that the loop of the target only has to queue it
+            ymsg_frame_builder frame(header.type, YES_STATUS_NOTIFY, target->id);
+            frame.add(YMSG_FLD_SENDER, sender.username)
+                 .add(YMSG_FLD_TARGET_USER, target->username)
+                 .add(YMSG_FLD_MSG, request.message)
+                 .add(YMSG_FLD_TIME, std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::system_clock::now().time_since_epoch()).count());
+
+            if (!request.utf8.empty()) {
+                frame.add(YMSG_FLD_UTF8_FLAG, request.utf8);
+            }
+
+            const auto routed = loop.route(*target, {
+                    .target_session = target->id,
+                    .origin_session = sender.id,
+                    .type = header.type,
+                    .target = std::string(request.target),
+                    .frame = frame.finish(),
+            });
+
+            if (!routed) {
+                SPDLOG_LOGGER_DEBUG(logging::server(), "Mailbox of thread {0} is full, dropped a message for {1}!",
+                                    target->shard, target->username);
+                conn.write(replies::message_not_delivered(header.type, YES_STATUS_ERR, sender.id, request.target));
+            }
+
+            return decoded(result);
+        }
+    }
+}
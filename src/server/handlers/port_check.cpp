@@ -22,23 +22,16 @@
 
 #include <server/handlers.h>
 
-#include <spdlog/spdlog.h>
+#include <logging/logging.h>
 
 namespace server {
     namespace handlers {
-        void handle_port_check(net::socket &sock, const net::protocol::ymsg_header &header,
-                                 const std::vector<net::protocol::ymsg_field> &fields) {
-            spdlog::get("server")->debug("YMSG port check!");
+        handler_result handle_port_check(connection &conn, const net::protocol::ymsg_header & /*header*/,
+                                         const net::protocol::ymsg_frame_view & /*fields*/) {
+            SPDLOG_LOGGER_DEBUG(logging::server(), "YMSG port check!");
 
-            net::serializer response;
-            response.emplace<net::protocol::ymsg_header>(16,
-                                                         0,
-                                                         0,
-                                                         YES_SEND_PORT_CHECK,
-                                                         YES_STATUS_NOTIFY,
-                                                         0);
-
-            sock.write(response);
+            conn.write(replies::port_check().instantiate(0));
+            return {};
         }
     }
 }
\ No newline at end of file
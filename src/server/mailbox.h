@@ -0,0 +1,214 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#ifdef __linux__
+
+#include <sys/eventfd.h>
+
+#include <net/pipe.h>
+
+#endif
+
+namespace server {
+    /**
+     * @brief Bounded lock-free queue through which any thread hands values to the thread owning the mailbox.
+     * @note Pushing wakes the owner through an eventfd, but only if no wake is pending yet, so a burst of values costs
+     * a single wake; the owner clears the pending wake when it starts draining. Where eventfd isn't available the
+     * owner only notices the values at the end of its current tick.
+     */
+    template<typename T>
+    struct mailbox {
+        /**
+         * @brief Constructor.
+         * @param capacity Number of slots; rounded up to a power of two.
+         */
+        explicit mailbox(std::size_t capacity)
+          : slots_(std::make_unique<slot[]>(std::bit_ceil(capacity))), mask_(std::bit_ceil(capacity) - 1) {
+            for (std::uint64_t i = 0; i <= mask_; i++) {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+#ifdef __linux__
+            // blocking, so that an io_uring read of it waits for a wake instead of failing right away; it is only
+            // read once it was seen readable, and writing it can't block before the count nears 2^64
+            wake_ = net::file_descriptor(::eventfd(0, EFD_CLOEXEC));
+#endif
+        }
+
+        mailbox(const mailbox &) = delete;
+        mailbox &operator=(const mailbox &) = delete;
+
+        /**
+         * @brief Tests if the mailbox can wake its owner.
+         * @return true if the wake handle is valid, or if there is none on this platform, false otherwise.
+         */
+        bool is_valid() const {
+#ifdef __linux__
+            return wake_.is_valid();
+#else
+            return true;
+#endif
+        }
+
+        /**
+         * @brief Gets the descriptor that becomes readable when values are pushed.
+         * @return The eventfd, or -1 if there is none on this platform.
+         */
+        int wake_handle() const {
+#ifdef __linux__
+            return wake_.get();
+#else
+            return -1;
+#endif
+        }
+
+        /**
+         * @brief Queues a value for the owner.
+         * @note Safe to call from any thread.
+         * @param value The value; left as it is if the mailbox is full.
+         * @return true if the value was queued, false if the mailbox is full.
+         */
+        bool push(T &&value) {
+            auto position = enqueue_position_.load(std::memory_order_relaxed);
+            slot *s;
+
+            while (true) {
+                s = &slots_[position & mask_];
+
+                const auto sequence = s->sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::int64_t>(sequence - position);
+
+                if (difference == 0) {
+                    if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = enqueue_position_.load(std::memory_order_relaxed);
+                }
+            }
+
+            s->value = std::move(value);
+            s->sequence.store(position + 1, std::memory_order_release);
+
+            wake();
+            return true;
+        }
+
+        /**
+         * @brief Hands the queued values to a function, at most a mailbox worth of them per call.
+         * @note Only call from the owning thread. If values are left over, the owner is woken again right away.
+         * @param f The function, called with every value.
+         * @return The number of values handed over.
+         */
+        template<typename F>
+        std::size_t drain(F &&f) {
+            // values pushed from here on wake the owner again
+            wake_pending_.exchange(false);
+
+            std::size_t drained = 0;
+
+            while (drained <= mask_) {
+                auto &s = slots_[dequeue_position_ & mask_];
+
+                if (s.sequence.load(std::memory_order_acquire) != dequeue_position_ + 1) {
+                    return drained;
+                }
+
+                auto value = std::move(s.value);
+                s.sequence.store(dequeue_position_ + mask_ + 1, std::memory_order_release);
+                dequeue_position_++;
+
+                f(std::move(value));
+                drained++;
+            }
+
+            wake();
+            return drained;
+        }
+
+        /**
+         * @brief Gets the number of values waiting.
+         * @note Only call from the owning thread. Values still being pushed are already counted.
+         * @return The number of values.
+         */
+        std::size_t size() const {
+            return enqueue_position_.load(std::memory_order_relaxed) - dequeue_position_;
+        }
+
+        /**
+         * @brief Resets the wake handle after it was seen readable.
+         * @note Only call from the owning thread, and only if the handle isn't read by other means, such as an
+         * io_uring read.
+         */
+        void clear_wake() {
+#ifdef __linux__
+            eventfd_t count;
+            ::eventfd_read(wake_.get(), &count);
+#endif
+        }
+
+    private:
+        struct slot {
+            // the position the slot is free for, or one past the position it holds a value of
+            std::atomic<std::uint64_t> sequence;
+            T value{};
+        };
+
+        /**
+         * @brief Wakes the owner, unless a wake is already pending.
+         */
+        void wake() {
+            if (wake_pending_.exchange(true)) {
+                return;
+            }
+
+#ifdef __linux__
+            ::eventfd_write(wake_.get(), 1);
+#endif
+        }
+
+        std::unique_ptr<slot[]> slots_;
+        std::uint64_t mask_;
+
+        alignas(64) std::atomic<std::uint64_t> enqueue_position_{0};
+        alignas(64) std::atomic<bool> wake_pending_{false};
+
+        // only touched by the owner
+        alignas(64) std::uint64_t dequeue_position_ = 0;
+
+#ifdef __linux__
+        net::file_descriptor wake_;
+#endif
+    };
+}  // namespace server
@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <string_view>
+
+#include <net/protocol/ymsg/ymsg_schema.h>
+
+namespace server {
+    namespace messages {
+        using namespace net::protocol;
+
+        struct helo {
+            std::string_view username;
+        };
+
+        using helo_schema = ymsg_schema<YES_HELO, helo,
+                ymsg_optional<YMSG_FLD_CURRENT_ID, &helo::username>>;
+
+        struct login_stage2 {
+            std::string_view username;
+            std::string_view cookie_y;
+            std::string_view cookie_t;
+            std::string_view crumb_hash;
+            std::string_view country_code{"unknown"};
+            std::string_view version{"unknown"};
+        };
+
+        using login_stage2_schema = ymsg_schema<YES_USER_LOGIN_2, login_stage2,
+                ymsg_required<YMSG_FLD_CURRENT_ID, &login_stage2::username>,
+                ymsg_optional<YMSG_FLD_LOGIN_Y_COOKIE, &login_stage2::cookie_y>,
+                ymsg_optional<YMSG_FLD_LOGIN_T_COOKIE, &login_stage2::cookie_t>,
+                ymsg_optional<YMSG_FLD_CRUMB_HASH, &login_stage2::crumb_hash>,
+                ymsg_optional<YMSG_FLD_COUNTRY_CODE, &login_stage2::country_code>,
+                ymsg_optional<YMSG_FLD_VERSION, &login_stage2::version>>;
+
+        struct instant_message {
+            std::string_view target;
+            std::string_view message;
+            std::string_view utf8;
+        };
+
+        // the sender is always the session; the alias clients put in YMSG_FLD_CURRENT_ID isn't checked
+        using instant_message_schema = ymsg_schema<YES_USER_HAS_MSG, instant_message,
+                ymsg_required<YMSG_FLD_TARGET_USER, &instant_message::target>,
+                ymsg_required<YMSG_FLD_MSG, &instant_message::message>,
+                ymsg_optional<YMSG_FLD_UTF8_FLAG, &instant_message::utf8>>;
+    }  // namespace messages
+}  // namespace server
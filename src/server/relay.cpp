@@ -0,0 +1,582 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifdef __linux__
+
+#include <server/event_loop.h>
+#include <server/relay.h>
+
+#include <sys/sendfile.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <optional>
+
+#include <logging/logging.h>
+
+namespace server {
+    // how long a single poll may block; one timer tick, like the YMSG event loops
+    constexpr auto POLL_TIMEOUT_MS = static_cast<std::int32_t>(TIMER_TICK.count());
+
+    // request heads are a few hundred bytes; anything longer is not a relay client
+    constexpr std::size_t MAX_REQUEST_HEAD = 4096;
+    constexpr std::size_t MAX_TOKEN_LENGTH = 128;
+
+    constexpr std::size_t PIPE_CAPACITY = 262144;
+
+    // larger uploads are refused up front; spool files are reserved at their full length when the upload starts, so
+    // that the relay as a whole never takes more than the quota of disk space
+    constexpr std::uint64_t MAX_TRANSFER_LENGTH = 256ull << 20;
+    constexpr std::uint64_t MAX_SPOOLED_BYTES = 4ull << 30;
+    constexpr std::size_t MAX_TRANSFERS = 4096;
+
+    // time to send the request head, then time a transfer may go without progress, waiting for the other side included
+    constexpr std::uint64_t REQUEST_TIMEOUT = std::chrono::seconds(10) / TIMER_TICK;
+    constexpr std::uint64_t TRANSFER_IDLE_TIMEOUT = std::chrono::seconds(120) / TIMER_TICK;
+
+    namespace {
+        struct request {
+            std::string_view method;
+            std::string_view token;
+            std::optional<std::uint64_t> content_length;
+        };
+
+        bool equals_ignore_case(std::string_view a, std::string_view b) {
+            return std::ranges::equal(a, b, [](char x, char y) {
+                return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+            });
+        }
+
+        bool is_valid_token(std::string_view token) {
+            return !token.empty() && token.size() <= MAX_TOKEN_LENGTH && std::ranges::all_of(token, [](char c) {
+                return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.' || c == '%';
+            });
+        }
+
+        /**
+         * @brief Parses the head of a relay request.
+         * @param head The request line and header lines, without the blank line ending them.
+         * @return The request, or std::nullopt if the head is malformed.
+         */
+        std::optional<request> parse_request(std::string_view head) {
+            request result;
+
+            const auto line_end = head.find("\r\n");
+            auto line = head.substr(0, line_end);
+            auto headers = line_end == std::string_view::npos ? std::string_view() : head.substr(line_end + 2);
+
+            // METHOD SP target SP HTTP/1.x
+            const auto method_end = line.find(' ');
+            if (method_end == std::string_view::npos) {
+                return std::nullopt;
+            }
+
+            result.method = line.substr(0, method_end);
+            line.remove_prefix(method_end + 1);
+
+            const auto target_end = line.find(' ');
+            if (target_end == std::string_view::npos || !line.substr(target_end + 1).starts_with("HTTP/1.")) {
+                return std::nullopt;
+            }
+
+            const auto target = line.substr(0, target_end);
+            const auto query_start = target.find('?');
+            auto query = query_start == std::string_view::npos ? std::string_view() : target.substr(query_start + 1);
+
+            while (!query.empty()) {
+                const auto end = query.find('&');
+                const auto parameter = query.substr(0, end);
+                query = end == std::string_view::npos ? std::string_view() : query.substr(end + 1);
+
+                if (parameter.starts_with("token=")) {
+                    result.token = parameter.substr(6);
+                }
+            }
+
+            while (!headers.empty()) {
+                const auto end = headers.find("\r\n");
+                const auto header = headers.substr(0, end);
+                headers = end == std::string_view::npos ? std::string_view() : headers.substr(end + 2);
+
+                const auto colon = header.find(':');
+                if (colon == std::string_view::npos || !equals_ignore_case(header.substr(0, colon), "Content-Length")) {
+                    continue;
+                }
+
+                auto value = header.substr(colon + 1);
+                while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+                    value.remove_prefix(1);
+                }
+
+                std::uint64_t length;
+                const auto [ptr, error] = std::from_chars(value.data(), value.data() + value.size(), length);
+                if (error != std::errc() || ptr != value.data() + value.size()) {
+                    return std::nullopt;
+                }
+
+                result.content_length = length;
+            }
+
+            return result;
+        }
+
+        /**
+         * @brief Opens an anonymous file to spool an upload into.
+         * @param directory The spool directory.
+         * @return The file, or an invalid descriptor on error.
+         */
+        net::file_descriptor open_spool(const std::string &directory) {
+            net::file_descriptor file(::open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600));
+            if (file.is_valid()) {
+                return file;
+            }
+
+            // file systems without O_TMPFILE
+            auto path = directory + "/ymredux-spool-XXXXXX";
+            file = net::file_descriptor(::mkostemp(path.data(), O_CLOEXEC));
+            if (file.is_valid()) {
+                ::unlink(path.c_str());
+            }
+
+            return file;
+        }
+
+        /**
+         * @brief Writes a short response head.
+         * @note Only used on fresh sockets with nothing else queued, where a few hundred bytes always fit.
+         * @return true if the whole head was written, false otherwise.
+         */
+        bool write_head(net::socket &socket, std::string_view status, std::uint64_t content_length) {
+            const auto head = fmt::format("HTTP/1.1 {0}\r\nContent-Length: {1}\r\nConnection: close\r\n\r\n", status,
+                                          content_length);
+
+            return socket.write_raw(head.data(), head.size()) == static_cast<std::int64_t>(head.size());
+        }
+
+        bool would_block() {
+            return net::impl::would_block() || net::impl::interrupted();
+        }
+    }  // namespace
+
+    relay::peer::peer(net::socket socket, net::endpoint endpoint, admission_control::slot admission_slot)
+      : socket(std::move(socket)), endpoint(endpoint), admission_slot(admission_slot) {}
+
+    relay::transfer::transfer(std::string token) : token(std::move(token)), pipe(PIPE_CAPACITY) {}
+
+    relay::relay(net::socket listener, std::string spool_directory)
+      : listener_(std::move(listener)),
+        spool_directory_(std::move(spool_directory)),
+        epoch_(std::chrono::steady_clock::now()) {}
+
+    bool relay::run() {
+        if (!poller_.is_valid() || !listener_.set_non_blocking()) {
+            logging::net()->error("Failed to set up the file transfer relay!");
+            return false;
+        }
+
+        if (!poller_.add(listener_.get(), net::poller::readable, nullptr)) {
+            logging::net()->error("Failed to watch the relay socket!");
+            return false;
+        }
+
+        std::array<net::poller::event, 256> events{};
+        running_ = true;
+
+        while (running_) {
+            const auto count = poller_.wait(events, POLL_TIMEOUT_MS);
+            if (count < 0) {
+                if (net::impl::interrupted()) {
+                    continue;
+                }
+
+                logging::net()->critical("Polling failed!");
+                return false;
+            }
+
+            for (std::int32_t i = 0; i < count; i++) {
+                const auto &event = events[i];
+
+                if (event.data == nullptr) {
+                    accept_peers();
+                    continue;
+                }
+
+                auto &p = *static_cast<peer *>(event.data);
+                if (p.closed) {
+                    continue;
+                }
+
+                if (p.owner == nullptr) {
+                    on_request(p);
+                    continue;
+                }
+
+                // a sender may hang up right after its last byte, which is still waiting to be spliced; a receiver has
+                // nothing left to say once its request is in
+                auto &t = *p.owner;
+                const auto receiver_gone = &p == t.receiver && (event.events & net::poller::hangup);
+
+                if ((event.events & net::poller::error) || receiver_gone || !pump(t)) {
+                    abort(t);
+                }
+            }
+
+            const auto now = current_tick();
+
+            request_timers_.advance(now, [this](net::timer &timer) {
+                auto &p = *static_cast<peer *>(timer.data());
+                logging::net()->info("Relay client {0} did not send a request in time!", p.endpoint.to_string());
+                close_peer(p);
+            });
+
+            transfer_timers_.advance(now, [this, now](net::timer &timer) {
+                auto &t = *static_cast<transfer *>(timer.data());
+                if (now - t.last_activity < TRANSFER_IDLE_TIMEOUT) {
+                    transfer_timers_.schedule(t.idle_timer, t.last_activity + TRANSFER_IDLE_TIMEOUT);
+                    return;
+                }
+
+                logging::net()->info("File transfer {0} timed out!", t.token);
+                abort(t);
+            });
+
+            closed_peers_.clear();
+        }
+
+        return true;
+    }
+
+    void relay::accept_peers() {
+        std::optional<std::pair<net::socket, net::endpoint>> client;
+        net::socket::accept_status status;
+
+        while ((status = listener_.accept(client)) == net::socket::accept_status::accepted) {
+            auto &[socket, endpoint] = client.value();
+            const auto handle = socket.get();
+
+            const auto slot = admission_.find(endpoint);
+            if (!admission_.admit(slot, request_timers_.now())) {
+                continue;
+            }
+
+            auto p = std::make_unique<peer>(std::move(socket), endpoint, slot);
+
+            if (!poller_.add(handle, net::poller::readable | net::poller::writable, p.get())) {
+                logging::net()->error("Failed to watch relay client {0}!", endpoint.to_string());
+                admission_.release(slot);
+                continue;
+            }
+
+            request_timers_.schedule(p->request_timer, request_timers_.now() + REQUEST_TIMEOUT);
+            peers_.emplace(handle, std::move(p));
+        }
+
+        if (status == net::socket::accept_status::failed) {
+            logging::net()->error("Failed to accept relay clients!");
+        }
+    }
+
+    void relay::on_request(peer &p) {
+        // only peek, so that body bytes that came along with the head stay in the socket for splice
+        std::array<char, MAX_REQUEST_HEAD> buffer{};
+        const auto peeked = ::recv(p.socket.get(), buffer.data(), buffer.size(), MSG_PEEK);
+
+        if (peeked == 0 || (peeked < 0 && !would_block())) {
+            close_peer(p);
+            return;
+        }
+
+        if (peeked < 0) {
+            return;
+        }
+
+        const std::string_view data(buffer.data(), peeked);
+        const auto head_end = data.find("\r\n\r\n");
+
+        if (head_end == std::string_view::npos) {
+            if (data.size() == buffer.size()) {
+                reject(p, "431 Request Header Fields Too Large");
+            }
+
+            return;
+        }
+
+        const auto head_length = static_cast<std::int64_t>(head_end + 4);
+        if (p.socket.read_raw(buffer.data(), head_length) != head_length) {
+            close_peer(p);
+            return;
+        }
+
+        const auto req = parse_request(data.substr(0, head_end));
+        if (!req.has_value() || !is_valid_token(req->token)) {
+            reject(p, "400 Bad Request");
+            return;
+        }
+
+        const auto is_upload = req->method == "POST";
+        if (!is_upload && req->method != "GET") {
+            reject(p, "405 Method Not Allowed");
+            return;
+        }
+
+        if (is_upload && !req->content_length.has_value()) {
+            reject(p, "411 Length Required");
+            return;
+        }
+
+        if (is_upload && *req->content_length > MAX_TRANSFER_LENGTH) {
+            reject(p, "413 Content Too Large");
+            return;
+        }
+
+        const std::string token(req->token);
+        auto it = transfers_.find(token);
+
+        if (it != transfers_.end() && (is_upload ? it->second->has_sender : it->second->receiver != nullptr)) {
+            reject(p, "409 Conflict");
+            return;
+        }
+
+        // uploads that start before their receiver shows up go to disk
+        net::file_descriptor spool;
+        if (is_upload && (it == transfers_.end() || it->second->receiver == nullptr)) {
+            if (spooled_bytes_ + *req->content_length > MAX_SPOOLED_BYTES) {
+                reject(p, "503 Service Unavailable");
+                return;
+            }
+
+            spool = open_spool(spool_directory_);
+
+            if (!spool.is_valid()) {
+                logging::net()->error("Failed to open a spool file in {0}!", spool_directory_);
+                reject(p, "503 Service Unavailable");
+                return;
+            }
+        }
+
+        if (it == transfers_.end()) {
+            if (transfers_.size() >= MAX_TRANSFERS) {
+                reject(p, "503 Service Unavailable");
+                return;
+            }
+
+            auto created = std::make_unique<transfer>(token);
+
+            if (!created->pipe.is_valid()) {
+                reject(p, "503 Service Unavailable");
+                return;
+            }
+
+            it = transfers_.emplace(token, std::move(created)).first;
+        }
+
+        auto &t = *it->second;
+        p.request_timer.cancel();
+        p.owner = &t;
+
+        if (is_upload) {
+            t.sender = &p;
+            t.has_sender = true;
+            t.length = *req->content_length;
+            t.spool = std::move(spool);
+
+            if (t.spool.is_valid()) {
+                t.spooled = t.length;
+                spooled_bytes_ += t.spooled;
+            }
+        } else {
+            t.receiver = &p;
+        }
+
+        logging::net()->info("Relay client {0} {1} file transfer {2}!", p.endpoint.to_string(),
+                             is_upload ? "sends" : "receives", t.token);
+
+        t.last_activity = transfer_timers_.now();
+        if (!t.idle_timer.scheduled()) {
+            transfer_timers_.schedule(t.idle_timer, t.last_activity + TRANSFER_IDLE_TIMEOUT);
+        }
+
+        if (!pump(t)) {
+            abort(t);
+        }
+    }
+
+    bool relay::pump(transfer &t) {
+        // a receiver that came first waits for its sender
+        if (!t.has_sender) {
+            return true;
+        }
+
+        if (t.receiver != nullptr && !t.headers_sent) {
+            if (!write_head(t.receiver->socket, "200 OK", t.length)) {
+                return false;
+            }
+
+            t.headers_sent = true;
+        }
+
+        while (true) {
+            std::uint64_t moved = 0;
+
+            // a full pipe waits for the receiver to drain it
+            if (t.sender != nullptr && t.received < t.length && t.in_pipe < t.pipe.capacity()) {
+                const auto room = t.pipe.capacity() - t.in_pipe;
+                const auto n = ::splice(t.sender->socket.get(), nullptr, t.pipe.write_end(), nullptr,
+                                        std::min<std::uint64_t>(room, t.length - t.received),
+                                        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+                // the sender went away before the whole body was in
+                if (n == 0 || (n < 0 && !would_block())) {
+                    return false;
+                }
+
+                if (n > 0) {
+                    t.received += n;
+                    t.in_pipe += n;
+                    moved += n;
+                }
+            }
+
+            // files never block, so a spooling pipe is always drained right away
+            if (t.spool.is_valid()) {
+                while (t.in_pipe > 0) {
+                    loff_t offset = static_cast<loff_t>(t.received - t.in_pipe);
+                    const auto n = ::splice(t.pipe.read_end(), nullptr, t.spool.get(), &offset, t.in_pipe,
+                                            SPLICE_F_MOVE);
+                    if (n <= 0) {
+                        logging::net()->error("Failed to spool file transfer {0}!", t.token);
+                        return false;
+                    }
+
+                    t.in_pipe -= n;
+                }
+            }
+
+            if (t.receiver != nullptr && t.spool.is_valid() && t.delivered < t.received) {
+                off_t offset = static_cast<off_t>(t.delivered);
+                const auto n = ::sendfile(t.receiver->socket.get(), t.spool.get(), &offset,
+                                          t.received - t.delivered);
+
+                if (n < 0 && !would_block()) {
+                    return false;
+                }
+
+                if (n > 0) {
+                    t.delivered += n;
+                    moved += n;
+                }
+            } else if (t.receiver != nullptr && !t.spool.is_valid() && t.in_pipe > 0) {
+                const auto n = ::splice(t.pipe.read_end(), nullptr, t.receiver->socket.get(), nullptr, t.in_pipe,
+                                        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+                if (n < 0 && !would_block()) {
+                    return false;
+                }
+
+                if (n > 0) {
+                    t.in_pipe -= n;
+                    t.delivered += n;
+                    moved += n;
+                }
+            }
+
+            if (moved == 0) {
+                break;
+            }
+
+            t.last_activity = transfer_timers_.now();
+        }
+
+        // everything is in; a spooled upload is done even if nobody picked it up yet
+        if (t.sender != nullptr && t.received == t.length) {
+            write_head(t.sender->socket, "200 OK", 0);
+            close_peer(*t.sender);
+            t.sender = nullptr;
+        }
+
+        if (t.receiver != nullptr && t.delivered == t.length) {
+            finish(t);
+        }
+
+        return true;
+    }
+
+    void relay::finish(transfer &t) {
+        logging::net()->info("File transfer {0} done, {1} bytes relayed!", t.token, t.delivered);
+
+        if (t.receiver != nullptr) {
+            close_peer(*t.receiver);
+        }
+
+        spooled_bytes_ -= t.spooled;
+        transfers_.erase(transfers_.find(t.token));
+    }
+
+    void relay::abort(transfer &t) {
+        logging::net()->warn("File transfer {0} aborted after {1} of {2} bytes!", t.token, t.delivered, t.length);
+
+        if (t.sender != nullptr) {
+            close_peer(*t.sender);
+        }
+
+        if (t.receiver != nullptr) {
+            close_peer(*t.receiver);
+        }
+
+        spooled_bytes_ -= t.spooled;
+        transfers_.erase(transfers_.find(t.token));
+    }
+
+    void relay::reject(peer &p, std::string_view status) {
+        logging::net()->info("Rejected relay client {0}: {1}", p.endpoint.to_string(), status);
+
+        write_head(p.socket, status, 0);
+        close_peer(p);
+    }
+
+    void relay::close_peer(peer &p) {
+        if (p.closed) {
+            return;
+        }
+
+        const auto handle = p.socket.get();
+
+        p.closed = true;
+        p.owner = nullptr;
+        p.request_timer.cancel();
+        poller_.remove(handle);
+        admission_.release(p.admission_slot);
+
+        // the socket is closed along with the peer, once the current batch of events is through
+        const auto it = peers_.find(handle);
+        closed_peers_.push_back(std::move(it->second));
+        peers_.erase(it);
+    }
+
+    std::uint64_t relay::current_tick() const {
+        return (std::chrono::steady_clock::now() - epoch_) / TIMER_TICK;
+    }
+}  // namespace server
+
+#endif
@@ -0,0 +1,163 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifdef __linux__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <net/pipe.h>
+#include <net/poller.h>
+#include <net/socket.h>
+#include <net/timing_wheel.h>
+
+#include <server/admission.h>
+
+namespace server {
+    /**
+     * @brief File transfer relay. Senders upload with "POST /relay?token=<token>" and a Content-Length, receivers
+     * download with "GET /relay?token=<token>"; the two are paired by token and may show up in any order.
+     * @note Runs on a thread of its own, away from the YMSG event loops, and file data never enters user space: if
+     * the receiver is already waiting, it is spliced from the sender through a pipe straight to the receiver;
+     * otherwise it is spliced into an unlinked spool file as it arrives, and sent from there with sendfile. Uploads,
+     * open transfers and the disk space taken by spool files are all capped.
+     */
+    struct relay {
+        /**
+         * @brief Constructor.
+         * @param listener A bound, listening socket. The relay switches it to non-blocking mode.
+         * @param spool_directory Directory for spool files.
+         */
+        relay(net::socket listener, std::string spool_directory);
+
+        relay(const relay &) = delete;
+        relay &operator=(const relay &) = delete;
+
+        /**
+         * @brief Runs the relay until stop() is called.
+         * @return true if the relay exited cleanly, false if it failed to start or to poll.
+         */
+        bool run();
+
+        /**
+         * @brief Asks the relay to exit.
+         * @note Safe to call from any thread and from signal handlers.
+         */
+        void stop() {
+            running_ = false;
+        }
+
+    private:
+        struct transfer;
+
+        struct peer {
+            net::socket socket;
+            net::endpoint endpoint;
+            admission_control::slot admission_slot;
+
+            // set once the request is parsed
+            transfer *owner = nullptr;
+            net::timer request_timer{this};
+            bool closed = false;
+
+            peer(net::socket socket, net::endpoint endpoint, admission_control::slot admission_slot);
+        };
+
+        struct transfer {
+            std::string token;
+
+            peer *sender = nullptr;
+            peer *receiver = nullptr;
+            bool has_sender = false;
+            bool headers_sent = false;
+
+            std::uint64_t length = 0;
+            std::uint64_t received = 0;
+            std::uint64_t delivered = 0;
+
+            // staging between splice calls; in direct mode it holds the bytes not delivered yet
+            net::pipe pipe;
+            std::uint64_t in_pipe = 0;
+
+            // only for transfers that started before their receiver showed up, with the bytes reserved for it
+            net::file_descriptor spool;
+            std::uint64_t spooled = 0;
+
+            // tick of the last progress; the idle timer is only moved when it fires
+            std::uint64_t last_activity = 0;
+            net::timer idle_timer{this};
+
+            explicit transfer(std::string token);
+        };
+
+        void accept_peers();
+
+        void on_request(peer &p);
+
+        /**
+         * @brief Moves as much data as the sockets of a transfer take, and finishes it once everything is delivered.
+         * @param t The transfer.
+         * @return false if the transfer failed and must be aborted, true otherwise.
+         */
+        bool pump(transfer &t);
+
+        void finish(transfer &t);
+
+        void abort(transfer &t);
+
+        void reject(peer &p, std::string_view status);
+
+        void close_peer(peer &p);
+
+        std::uint64_t current_tick() const;
+
+        net::poller poller_;
+        net::socket listener_;
+        std::string spool_directory_;
+        std::atomic<bool> running_{false};
+
+        std::chrono::steady_clock::time_point epoch_;
+        net::timing_wheel request_timers_;
+        net::timing_wheel transfer_timers_;
+        admission_control admission_;
+
+        std::unordered_map<net::socket_type, std::unique_ptr<peer>> peers_;
+        std::unordered_map<std::string, std::unique_ptr<transfer>> transfers_;
+
+        // bytes reserved by the spool files of all transfers
+        std::uint64_t spooled_bytes_ = 0;
+
+        // events of the current batch may still point at peers closed while handling it
+        std::vector<std::unique_ptr<peer>> closed_peers_;
+    };
+}  // namespace server
+
+#endif
@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <server/replies.h>
+
+#include <net/protocol/ymsg/ymsg_frame_builder.h>
+
+using namespace net::protocol;
+
+namespace server {
+    namespace replies {
+        // each reply is encoded on first use; the function-local statics make that safe from every loop thread
+
+        const ymsg_frame_template &port_check() {
+            static const ymsg_frame_template reply(YES_SEND_PORT_CHECK, YES_STATUS_NOTIFY);
+            return reply;
+        }
+
+        const ymsg_frame_template &helo() {
+            static const auto reply = [] {
+                ymsg_frame_template t(YES_HELO, YES_STATUS_NOTIFY);
+                t.add_slot(YMSG_FLD_CURRENT_ID)
+                 .add(YMSG_FLD_FLAG, "2")
+                 .add_slot(YMSG_FLD_CHALLENGE);
+                return t;
+            }();
+            return reply;
+        }
+
+        const ymsg_frame_template &login_failed() {
+            static const auto reply = [] {
+                ymsg_frame_template t(YES_USER_LOGIN_2, YES_STATUS_ERR);
+                t.add_slot(YMSG_FLD_ERROR_CODE);
+                return t;
+            }();
+            return reply;
+        }
+
+        const ymsg_frame_template &login_succeeded() {
+            static const auto reply = [] {
+                ymsg_frame_template t(YES_USER_LOGIN, YES_STATUS_OK);
+                t.add_slot(YMSG_FLD_USER_NAME)
+                 .add_slot(YMSG_FLD_CURRENT_ID);
+                return t;
+            }();
+            return reply;
+        }
+
+        net::gather_list message_not_delivered(YES_ type, YES_STATUS_ status, std::uint32_t session_id,
+                                               std::string_view target) {
+            // the type and status vary, so this one is built per send
+            ymsg_frame_builder reply(type, status, session_id);
+            reply.add(YMSG_FLD_TARGET_USER, target);
+            return reply.finish();
+        }
+
+        const ymsg_frame_template &feature_not_supported() {
+            static const ymsg_frame_template reply(YES_FEATURE_NOT_SUPPORTED, YES_STATUS_ERR);
+            return reply;
+        }
+
+        const ymsg_frame_template &ping() {
+            static const ymsg_frame_template reply(YES_PING);
+            return reply;
+        }
+    }  // namespace replies
+}  // namespace server
@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include <net/gather_list.h>
+
+#include <net/protocol/ymsg/enums/ymsg_message_type.hpp>
+#include <net/protocol/ymsg/enums/ymsg_status_type.hpp>
+#include <net/protocol/ymsg/ymsg_frame_template.h>
+
+namespace server {
+    namespace replies {
+        /**
+         * @brief Acknowledgement of YES_SEND_PORT_CHECK.
+         * @return The reply; no slots.
+         */
+        const net::protocol::ymsg_frame_template &port_check();
+
+        /**
+         * @brief Answer to YES_HELO.
+         * @return The reply; slots: username, challenge.
+         */
+        const net::protocol::ymsg_frame_template &helo();
+
+        /**
+         * @brief Rejection of YES_USER_LOGIN_2.
+         * @return The reply; slots: error code.
+         */
+        const net::protocol::ymsg_frame_template &login_failed();
+
+        /**
+         * @brief Acceptance of YES_USER_LOGIN_2.
+         * @return The reply; slots: username, current ID.
+         */
+        const net::protocol::ymsg_frame_template &login_succeeded();
+
+        /**
+         * @brief Tells the sender of an instant message that it wasn't delivered.
+         * @param type The type the message was sent as.
+         * @param status YES_STATUS_INVALID_USER if the target isn't logged in, YES_STATUS_ERR if it couldn't be
+         * reached.
+         * @param session_id The session ID of the sender.
+         * @param target The username the message was sent to.
+         * @return The reply.
+         */
+        net::gather_list message_not_delivered(net::protocol::YES_ type, net::protocol::YES_STATUS_ status,
+                                               std::uint32_t session_id, std::string_view target);
+
+        /**
+         * @brief Answer to message types the server has no handler for.
+         * @return The reply; no slots.
+         */
+        const net::protocol::ymsg_frame_template &feature_not_supported();
+
+        /**
+         * @brief Ping sent to quiet clients.
+         * @return The reply; no slots.
+         */
+        const net::protocol::ymsg_frame_template &ping();
+    }  // namespace replies
+}  // namespace server
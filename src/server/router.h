@@ -0,0 +1,112 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <net/gather_list.h>
+
+#include <net/protocol/ymsg/enums/ymsg_message_type.hpp>
+
+#include <server/mailbox.h>
+
+namespace server {
+    /**
+     * @brief A frame on its way to a session that may belong to another event loop.
+     */
+    struct routed_message {
+        // the session the frame is addressed to
+        std::uint32_t target_session = 0;
+
+        // the session told if the target is gone by the time the frame arrives, or 0 for nobody
+        std::uint32_t origin_session = 0;
+        net::protocol::YES_ type = net::protocol::YES_USER_HAS_MSG;
+
+        // username of the target, for telling the origin
+        std::string target;
+
+        net::gather_list frame;
+    };
+
+    /**
+     * @brief The mailboxes through which the event loops of the server hand each other frames, so that every socket
+     * is only ever written by the loop owning it.
+     */
+    struct message_router {
+        // frames a loop may have waiting before posting to it fails
+        constexpr static std::size_t MAILBOX_CAPACITY = 16384;
+
+        /**
+         * @brief Constructor.
+         * @param shards The number of event loops.
+         */
+        explicit message_router(std::uint32_t shards) {
+            for (std::uint32_t i = 0; i < shards; i++) {
+                mailboxes_.push_back(std::make_unique<mailbox<routed_message>>(MAILBOX_CAPACITY));
+            }
+        }
+
+        /**
+         * @brief Tests if every mailbox can wake its loop.
+         * @return true if the router is usable, false otherwise.
+         */
+        bool is_valid() const {
+            for (const auto &m: mailboxes_) {
+                if (!m->is_valid()) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Hands a frame to an event loop.
+         * @note Safe to call from any thread.
+         * @param shard The shard of the loop.
+         * @param message The frame.
+         * @return true if the frame was posted, false if the mailbox of the loop is full.
+         */
+        bool post(std::uint32_t shard, routed_message &&message) {
+            return mailboxes_[shard]->push(std::move(message));
+        }
+
+        /**
+         * @brief Gets the mailbox of an event loop.
+         * @param shard The shard of the loop.
+         * @return The mailbox, to be drained only by that loop.
+         */
+        mailbox<routed_message> &mailbox_of(std::uint32_t shard) {
+            return *mailboxes_[shard];
+        }
+
+    private:
+        std::vector<std::unique_ptr<mailbox<routed_message>>> mailboxes_;
+    };
+}  // namespace server
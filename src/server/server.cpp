@@ -20,37 +20,93 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
-#include <server/server.h>
+#include <server/handler_registry.h>
 #include <server/handlers.h>
+#include <server/replies.h>
+#include <server/server.h>
 
-#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 
-using namespace net::protocol;
+#include <logging/logging.h>
 
-// i ain't pasting this stuff 10001 times for each and every handler ~ r0neko, 14/03/2024
-#define DEFINE_YMSG_HANDLER(op_code, handler) \
-    case op_code: \
-        handler(sock, header, fields); \
-        break;
+using namespace net::protocol;
 
 namespace server {
-    void handle_frame(net::socket &sock, const ymsg_header &header,
-                      const std::vector<ymsg_field> &fields) {
-        spdlog::get("server")->debug("Handling frame type {0}, status {1:X}", (int) header.type, (int) header.status);
+    namespace {
+        constexpr handler_registry HANDLERS{
+            {YES_SEND_PORT_CHECK, {handlers::handle_port_check, session_state::connected}},
+            {YES_HELO, {handlers::handle_helo}},
+            {YES_USER_LOGIN_2, {handlers::handle_login_stage2, session_state::greeted}},
+            {YES_USER_LOGOFF, {handlers::handle_logoff, session_state::logged_in}},
+            {YES_USER_HAS_MSG, {handlers::handle_message, session_state::logged_in}},
+            {YES_USER_SEND_MESG, {handlers::handle_message, session_state::logged_in}},
+            {YES_PING, {handlers::handle_keep_alive, session_state::connected}},
+            {YES_KEEP_ALIVE, {handlers::handle_keep_alive, session_state::connected}},
+            {YES_CHAT_PING, {handlers::handle_keep_alive, session_state::connected}},
+        };
+    }
+
+    bool handle_frame(connection &conn, const ymsg_header &header, const ymsg_frame_view &fields) {
+        conn.metrics().frame_received(header.type, header.status);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        flight_entry record{
+                .timestamp = static_cast<std::uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count()),
+                .session_id = header.session_id,
+                .status = header.status,
+                .type = header.type,
+                .length = header.length,
+                .fields = flight_entry::FIELDS_NOT_COUNTED,
+        };
+
+        const auto *entry = HANDLERS.find(header.type);
+
+        if (entry == nullptr) {
+            SPDLOG_LOGGER_DEBUG(logging::server(), "No handler for frame type {0} from {1}!", (int) header.type,
+                                conn.endpoint().to_string());
+            conn.write(replies::feature_not_supported().instantiate(conn.session_id()));
 
-        for (const auto &field: fields) {
-            spdlog::get("server")->debug("{0} = {1}", (int) field.key, field.value.data());
+            record.outcome = frame_outcome::unknown_type;
+            conn.frame_dispatched(record);
+            return true;
         }
 
-        switch(header.type) {
-            DEFINE_YMSG_HANDLER(YES_SEND_PORT_CHECK, handlers::handle_port_check)
-            DEFINE_YMSG_HANDLER(YES_HELO, handlers::handle_helo)
-            DEFINE_YMSG_HANDLER(YES_USER_LOGIN_2, handlers::handle_login_stage2)
-            default:
-                spdlog::get("server")->error("No case associated for this type!");
-                break;
+        if (conn.state() < entry->required_state) {
+            // not logged above debug, since a client could otherwise flood the log at the full frame rate
+            SPDLOG_LOGGER_DEBUG(logging::server(), "Frame type {0} from {1} arrived too early in the handshake!",
+                                (int) header.type, conn.endpoint().to_string());
+
+            record.outcome = frame_outcome::too_early;
+            conn.frame_dispatched(record);
+            return true;
+        }
+
+        // handlers that decode the fields check and count them in the same pass
+        const auto result = entry->handler(conn, header, fields);
+
+        if (result.fields.has_value()) {
+            record.fields = static_cast<std::uint16_t>(
+                    std::min<std::size_t>(*result.fields, flight_entry::FIELDS_NOT_COUNTED - 1));
+        }
+
+        if (result.malformed) {
+            logging::net()->critical("Malformed field in frame from {0}!", conn.endpoint().to_string());
+
+            record.outcome = frame_outcome::malformed;
+            conn.frame_dispatched(record);
+            return false;
         }
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        conn.metrics().frame_handled(header.type, header.status, elapsed);
+
+        record.handler_time = static_cast<std::uint32_t>(std::min<std::int64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), UINT32_MAX));
+        conn.frame_dispatched(record);
+        return true;
     }
 }
-
-#undef DEFINE_YMSG_HANDLER
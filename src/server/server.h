@@ -22,13 +22,21 @@
 
 #pragma once
 
-#include <net/socket.h>
+#include <server/connection.h>
 #include <net/packet.h>
 
 #include <net/protocol/ymsg/ymsg_header.h>
-#include <net/protocol/ymsg/ymsg_field.h>
+#include <net/protocol/ymsg/ymsg_field_view.h>
 
 namespace server {
-    void handle_frame(net::socket &sock, const net::protocol::ymsg_header &header,
-                      const std::vector <net::protocol::ymsg_field> &fields);
+    /**
+     * @brief Routes a frame to the handler registered for its type; types without one are answered with
+     * YES_FEATURE_NOT_SUPPORTED.
+     * @param conn The connection the frame came from.
+     * @param header The header of the frame.
+     * @param fields The fields of the frame.
+     * @return true if the connection is still usable, false if it must be closed.
+     */
+    bool handle_frame(connection &conn, const net::protocol::ymsg_header &header,
+                      const net::protocol::ymsg_frame_view &fields);
 }
\ No newline at end of file
@@ -0,0 +1,353 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <server/session_table.h>
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace server {
+    namespace {
+        // per shard sequences wrap here, since the shard takes the low bits of the 32-bit ID
+        constexpr std::uint32_t SEQUENCE_LIMIT = 1U << (32 - session_table::SHARD_BITS);
+
+        constexpr std::size_t INITIAL_CAPACITY = 64;
+
+        // left in the slot of a removed session, so that probes for keys further along don't stop there
+        const session REMOVED_MARKER;
+        const session *const REMOVED = &REMOVED_MARKER;
+
+        std::size_t hash_of(std::uint32_t id) {
+            // sequences are handed out in order, which linear probing handles without collisions
+            return id >> session_table::SHARD_BITS;
+        }
+
+        std::size_t hash_of(std::string_view username) {
+            return std::hash<std::string_view>{}(username);
+        }
+
+        template<typename Key>
+        Key key_of(const session &s) {
+            if constexpr (std::is_same_v<Key, std::uint32_t>) {
+                return s.id;
+            } else {
+                return s.username;
+            }
+        }
+
+        struct slot_array {
+            explicit slot_array(std::size_t capacity)
+              : mask(capacity - 1), slots(std::make_unique<std::atomic<const session *>[]>(capacity)) {}
+
+            std::size_t mask;
+            std::unique_ptr<std::atomic<const session *>[]> slots;
+        };
+
+        /**
+         * @brief Open addressed index of sessions by one of their keys, with one writer at a time and any number of
+         * readers that take no lock.
+         * @note Keys are read out of the sessions, so every slot is a single pointer that changes atomically. Slots
+         * of removed sessions are marked rather than emptied, and the array is rebuilt into a new one before half of
+         * it is used, so probes stay short and always reach an empty slot.
+         */
+        template<typename Key>
+        struct session_index {
+            session_index() : slots_(new slot_array(INITIAL_CAPACITY)) {}
+
+            ~session_index() {
+                delete slots_.load(std::memory_order_relaxed);
+            }
+
+            session_index(const session_index &) = delete;
+            session_index &operator=(const session_index &) = delete;
+
+            /**
+             * @brief Finds a session.
+             * @param key The key of the session.
+             * @param hash The hash of the key.
+             * @return The session, or nullptr if there is none with that key.
+             */
+            const session *find(Key key, std::size_t hash) const {
+                const auto *array = slots_.load(std::memory_order_acquire);
+
+                for (auto i = hash & array->mask;; i = (i + 1) & array->mask) {
+                    const auto *s = array->slots[i].load(std::memory_order_acquire);
+
+                    if (s == nullptr) {
+                        return nullptr;
+                    }
+
+                    if (s != REMOVED && key_of<Key>(*s) == key) {
+                        return s;
+                    }
+                }
+            }
+
+            /**
+             * @brief Publishes a session, in place of the session with the same key if there is one.
+             * @param s The session.
+             * @param hash The hash of its key.
+             * @return The array the index outgrew, which readers may still be probing, or nullptr.
+             */
+            std::unique_ptr<slot_array> insert(const session *s, std::size_t hash) {
+                std::unique_ptr<slot_array> outgrown;
+                auto *array = slots_.load(std::memory_order_relaxed);
+
+                if ((used_ + 1) * 2 > array->mask + 1) {
+                    outgrown.reset(array);
+                    array = rebuild(*array);
+                }
+
+                std::atomic<const session *> *free = nullptr;
+                auto i = hash & array->mask;
+
+                for (;; i = (i + 1) & array->mask) {
+                    const auto *current = array->slots[i].load(std::memory_order_relaxed);
+
+                    if (current == nullptr) {
+                        break;
+                    }
+
+                    if (current == REMOVED) {
+                        free = free != nullptr ? free : &array->slots[i];
+                    } else if (key_of<Key>(*current) == key_of<Key>(*s)) {
+                        array->slots[i].store(s, std::memory_order_release);
+                        return outgrown;
+                    }
+                }
+
+                if (free == nullptr) {
+                    free = &array->slots[i];
+                    used_++;
+                }
+
+                free->store(s, std::memory_order_release);
+                live_++;
+                return outgrown;
+            }
+
+            /**
+             * @brief Unpublishes a session, unless another session took its place.
+             * @param s The session.
+             * @param hash The hash of its key.
+             */
+            void erase(const session *s, std::size_t hash) {
+                auto *array = slots_.load(std::memory_order_relaxed);
+
+                for (auto i = hash & array->mask;; i = (i + 1) & array->mask) {
+                    const auto *current = array->slots[i].load(std::memory_order_relaxed);
+
+                    if (current == nullptr) {
+                        return;
+                    }
+
+                    if (current == s) {
+                        array->slots[i].store(REMOVED, std::memory_order_release);
+                        live_--;
+                        return;
+                    }
+                }
+            }
+
+            /**
+             * @brief Calls a function with every published session.
+             * @note Only call while nothing writes to the index.
+             * @param f The function.
+             */
+            template<typename F>
+            void for_each(F &&f) const {
+                const auto *array = slots_.load(std::memory_order_acquire);
+
+                for (std::size_t i = 0; i <= array->mask; i++) {
+                    const auto *s = array->slots[i].load(std::memory_order_relaxed);
+
+                    if (s != nullptr && s != REMOVED) {
+                        f(s);
+                    }
+                }
+            }
+
+        private:
+            /**
+             * @brief Moves the published sessions into a new array, sized for a quarter of it to be used, and
+             * publishes the array.
+             * @param old The current array, left as it is for the readers still probing it.
+             * @return The new array.
+             */
+            slot_array *rebuild(const slot_array &old) {
+                auto *array = new slot_array(std::bit_ceil(std::max(INITIAL_CAPACITY, (live_ + 1) * 4)));
+
+                for (std::size_t i = 0; i <= old.mask; i++) {
+                    const auto *s = old.slots[i].load(std::memory_order_relaxed);
+
+                    if (s == nullptr || s == REMOVED) {
+                        continue;
+                    }
+
+                    auto j = hash_of(key_of<Key>(*s)) & array->mask;
+                    while (array->slots[j].load(std::memory_order_relaxed) != nullptr) {
+                        j = (j + 1) & array->mask;
+                    }
+
+                    array->slots[j].store(s, std::memory_order_relaxed);
+                }
+
+                used_ = live_;
+                slots_.store(array, std::memory_order_release);
+                return array;
+            }
+
+            std::atomic<slot_array *> slots_;
+
+            // slots holding a session or a removal marker, and slots holding a session
+            std::size_t used_ = 0;
+            std::size_t live_ = 0;
+        };
+
+        /**
+         * @brief Something unpublished, kept until no loop can be reading it any more.
+         */
+        struct retired_object {
+            // the epoch the removal bumped the table to
+            std::uint64_t epoch;
+
+            std::unique_ptr<const session> removed;
+            std::unique_ptr<slot_array> array;
+        };
+    }  // namespace
+
+    struct alignas(64) session_table::shard {
+        // last epoch the loop of the shard saw at the end of a tick
+        std::atomic<std::uint64_t> seen_epoch{0};
+
+        // only touched by the loop of the shard, which is also the only writer of the ID index
+        std::uint32_t last_sequence = 0;
+        std::vector<retired_object> retired;
+        session_index<std::uint32_t> ids;
+
+        // written by whichever loop logs in or out a user whose name hashes to this shard
+        std::mutex names_lock;
+        session_index<std::string_view> names;
+    };
+
+    session_table::session_table(std::uint32_t shards)
+      : shard_count_(shards), shards_(std::make_unique<shard[]>(shards)) {}
+
+    session_table::~session_table() {
+        for (std::uint32_t i = 0; i < shard_count_; i++) {
+            shards_[i].ids.for_each([](const session *s) {
+                delete s;
+            });
+        }
+    }
+
+    const session *session_table::create(std::uint32_t shard, std::string_view username, connection *conn,
+                                         std::uint64_t connection_id) {
+        auto &owner = shards_[shard];
+        std::uint32_t id;
+
+        // once the sequence wraps, IDs still held by live sessions are skipped; 0 is never handed out
+        do {
+            owner.last_sequence = owner.last_sequence + 1 == SEQUENCE_LIMIT ? 1 : owner.last_sequence + 1;
+            id = owner.last_sequence << SHARD_BITS | shard;
+        } while (owner.ids.find(id, hash_of(id)) != nullptr);
+
+        const auto *s = new session{id, shard, connection_id, std::string(username), conn};
+
+        if (auto outgrown = owner.ids.insert(s, hash_of(id))) {
+            owner.retired.push_back({epoch_.fetch_add(1) + 1, nullptr, std::move(outgrown)});
+        }
+
+        const auto hash = hash_of(s->username);
+        auto &names = name_shard(hash);
+        std::unique_ptr<slot_array> outgrown;
+
+        {
+            std::lock_guard lock(names.names_lock);
+            outgrown = names.names.insert(s, hash);
+        }
+
+        if (outgrown != nullptr) {
+            owner.retired.push_back({epoch_.fetch_add(1) + 1, nullptr, std::move(outgrown)});
+        }
+
+        return s;
+    }
+
+    void session_table::remove(std::uint32_t shard, const session *s) {
+        auto &owner = shards_[shard];
+        owner.ids.erase(s, hash_of(s->id));
+
+        const auto hash = hash_of(s->username);
+        auto &names = name_shard(hash);
+
+        {
+            std::lock_guard lock(names.names_lock);
+            names.names.erase(s, hash);
+        }
+
+        owner.retired.push_back({epoch_.fetch_add(1) + 1, std::unique_ptr<const session>(s), nullptr});
+    }
+
+    const session *session_table::find(std::uint32_t id) const {
+        const auto shard = id & (MAX_SHARDS - 1);
+
+        if (shard >= shard_count_) {
+            return nullptr;
+        }
+
+        return shards_[shard].ids.find(id, hash_of(id));
+    }
+
+    const session *session_table::find(std::string_view username) const {
+        const auto hash = hash_of(username);
+        return name_shard(hash).names.find(username, hash);
+    }
+
+    void session_table::quiescent(std::uint32_t shard) {
+        auto &owner = shards_[shard];
+        owner.seen_epoch.store(epoch_.load());
+
+        if (owner.retired.empty()) {
+            return;
+        }
+
+        auto oldest = std::numeric_limits<std::uint64_t>::max();
+        for (std::uint32_t i = 0; i < shard_count_; i++) {
+            oldest = std::min(oldest, shards_[i].seen_epoch.load());
+        }
+
+        std::erase_if(owner.retired, [oldest](const retired_object &r) {
+            return r.epoch <= oldest;
+        });
+    }
+
+    session_table::shard &session_table::name_shard(std::size_t hash) const {
+        // the index takes the low bits of the hash, so the shard is picked from the high bits of its Fibonacci mix
+        return shards_[(static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL >> 32) % shard_count_];
+    }
+}  // namespace server
@@ -0,0 +1,137 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace server {
+    struct connection;
+
+    /**
+     * @brief A logged in user.
+     * @note Never changes once published, so every event loop may read it; only the loop owning the connection acts on
+     * the connection itself.
+     */
+    struct session {
+        // unique among the live sessions; the low SHARD_BITS bits are the shard of the owning loop
+        std::uint32_t id = 0;
+        std::uint32_t shard = 0;
+        std::uint64_t connection_id = 0;
+        std::string username;
+
+        // only to be used by the owning loop, which may rely on it being alive for as long as the session is found
+        connection *conn = nullptr;
+    };
+
+    /**
+     * @brief Maps usernames and session IDs to the sessions of every event loop.
+     * @note Lookups take no lock and may run on any loop thread. Writers only lock the shard they touch: session IDs
+     * are indexed in the shard of the owning loop, which is the only writer there, and usernames are indexed in the
+     * shard their hash picks, behind a lock of that shard. Removed sessions are freed once every loop has finished the
+     * tick it was in, so a session found during a tick stays readable until the end of that tick.
+     */
+    struct session_table {
+        // session IDs keep the shard of their loop in this many low bits, and a per shard sequence above them
+        constexpr static std::uint32_t SHARD_BITS = 8;
+        constexpr static std::uint32_t MAX_SHARDS = 1U << SHARD_BITS;
+
+        /**
+         * @brief Constructor.
+         * @param shards The number of event loops, at most MAX_SHARDS.
+         */
+        explicit session_table(std::uint32_t shards);
+
+        /**
+         * @brief Destructor; frees every session left.
+         * @note Only destroy the table after every event loop stopped.
+         */
+        ~session_table();
+
+        session_table(const session_table &) = delete;
+        session_table &operator=(const session_table &) = delete;
+
+        /**
+         * @brief Creates a session and publishes it to every loop.
+         * @note A user logging in again replaces the older session in the username index; the older session can still
+         * be found by its ID until it is removed.
+         * @param shard The shard of the calling loop, which owns the session.
+         * @param username The username.
+         * @param conn The connection of the session.
+         * @param connection_id The ID of the connection.
+         * @return The session.
+         */
+        const session *create(std::uint32_t shard, std::string_view username, connection *conn,
+                              std::uint64_t connection_id);
+
+        /**
+         * @brief Unpublishes a session; it is freed once no loop can be reading it any more.
+         * @param shard The shard of the calling loop, which must own the session.
+         * @param s The session.
+         */
+        void remove(std::uint32_t shard, const session *s);
+
+        /**
+         * @brief Finds a session by ID.
+         * @note Only call from event loop threads; the session is only valid until the end of the current tick.
+         * @param id The session ID.
+         * @return The session, or nullptr if there is none with that ID.
+         */
+        const session *find(std::uint32_t id) const;
+
+        /**
+         * @brief Finds the latest session of a user.
+         * @note Only call from event loop threads; the session is only valid until the end of the current tick.
+         * @param username The username.
+         * @return The session, or nullptr if the user isn't logged in.
+         */
+        const session *find(std::string_view username) const;
+
+        /**
+         * @brief Marks the end of a tick of a loop, after which it holds no session it found, and frees whatever
+         * the loop removed that no loop can be reading any more.
+         * @param shard The shard of the calling loop.
+         */
+        void quiescent(std::uint32_t shard);
+
+    private:
+        struct shard;
+
+        /**
+         * @brief Gets the shard indexing a username.
+         * @param hash The hash of the username.
+         * @return The shard.
+         */
+        shard &name_shard(std::size_t hash) const;
+
+        std::uint32_t shard_count_;
+        std::unique_ptr<shard[]> shards_;
+
+        // bumped by every removal; a loop that saw an epoch at the end of a tick holds nothing removed up to it
+        std::atomic<std::uint64_t> epoch_{0};
+    };
+}  // namespace server
@@ -0,0 +1,391 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifdef __linux__
+
+#include <server/uring_loop.h>
+
+#include <algorithm>
+
+#include <logging/logging.h>
+
+namespace server {
+    // how long a single wait may block; one timer tick, so that timers and stop() are handled in time without having
+    // to wake the loop up
+    constexpr auto WAIT_TIMEOUT_MS = static_cast<std::int32_t>(TIMER_TICK.count());
+
+    constexpr std::uint32_t RING_ENTRIES = 4096;
+
+    // provided receive buffers shared by every connection of the loop
+    constexpr std::uint16_t RECV_BUFFER_GROUP = 0;
+    constexpr std::uint16_t RECV_BUFFER_COUNT = 1024;
+    constexpr std::uint32_t RECV_BUFFER_SIZE = 4096;
+
+    // the listener is not a client, connection IDs start at 1
+    constexpr std::uint64_t LISTENER_ID = 0;
+
+    uring_loop::uring_loop(std::uint32_t shard, session_table &sessions, message_router &router,
+                           net::socket listener)
+      : event_loop(shard, sessions, router), listener_(std::move(listener)), ring_(RING_ENTRIES) {}
+
+    bool uring_loop::run() {
+        if (!ring_.is_valid()) {
+            logging::net()->error("Failed to set up io_uring!");
+            return false;
+        }
+
+        buffers_ = std::make_unique<net::uring_buffer_ring>(ring_, RECV_BUFFER_GROUP, RECV_BUFFER_COUNT,
+                                                             RECV_BUFFER_SIZE);
+        if (!buffers_->is_valid()) {
+            logging::net()->error("Failed to register io_uring receive buffers!");
+            return false;
+        }
+
+        if (!arm_accept()) {
+            logging::net()->error("Failed to start accepting connections!");
+            return false;
+        }
+
+        if (!arm_wake()) {
+            logging::net()->error("Failed to watch the mailbox!");
+            return false;
+        }
+
+        running_ = true;
+
+        while (running_) {
+            flush();
+            buffers_->publish();
+
+            const auto result = ring_.submit_and_wait(1, WAIT_TIMEOUT_MS);
+            if (result < 0 && result != -ETIME && result != -EINTR && result != -EBUSY) {
+                logging::net()->critical("io_uring_enter failed with error {0}!", -result);
+                return false;
+            }
+
+            ring_.for_each_completion([this](const io_uring_cqe &cqe) {
+                switch (static_cast<operation>(cqe.user_data & 0xFF)) {
+                    case op_accept:
+                        on_accept(cqe);
+                        break;
+                    case op_recv:
+                        on_recv(cqe);
+                        break;
+                    case op_send:
+                        on_send(cqe);
+                        break;
+                    case op_wake:
+                        // the mailbox is drained below either way; the read only has to be put back
+                        if (!arm_wake()) {
+                            logging::net()->critical("Failed to watch the mailbox again!");
+                        }
+                        break;
+                }
+            });
+
+            timers().advance(current_tick(), [this](net::timer &t) {
+                auto &c = clients_.at(static_cast<connection *>(t.data())->id());
+                if (!c.closing && !c.conn->on_timer(t)) {
+                    close_client(c);
+                }
+            });
+
+            // frames from other loops go out with the next flush
+            drain_mailbox();
+
+            if (!congested_.empty()) {
+                evict_congested();
+            }
+
+            if (take_dump_request()) {
+                for (const auto &[id, c] : clients_) {
+                    if (!c.closing) {
+                        c.conn->dump_flight_recorder(spdlog::level::info, "requested");
+                    }
+                }
+            }
+
+            flush_captures();
+
+            // no session found during the tick is held past this point
+            sessions().quiescent(shard());
+        }
+
+        return true;
+    }
+
+    void uring_loop::schedule_flush(connection &conn) {
+        const auto it = clients_.find(conn.id());
+        if (it == clients_.end() || it->second.dirty || it->second.closing) {
+            return;
+        }
+
+        it->second.dirty = true;
+        dirty_.push_back(conn.id());
+    }
+
+    bool uring_loop::arm_accept() {
+        auto *sqe = ring_.get_sqe();
+        if (sqe == nullptr) {
+            return false;
+        }
+
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = listener_.get();
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->user_data = user_data(LISTENER_ID, op_accept);
+        return true;
+    }
+
+    bool uring_loop::arm_wake() {
+        auto *sqe = ring_.get_sqe();
+        if (sqe == nullptr) {
+            return false;
+        }
+
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = router().mailbox_of(shard()).wake_handle();
+        sqe->addr = reinterpret_cast<std::uint64_t>(&wake_count_);
+        sqe->len = sizeof(wake_count_);
+        sqe->user_data = user_data(LISTENER_ID, op_wake);
+        return true;
+    }
+
+    bool uring_loop::arm_recv(std::uint64_t id, client &c) {
+        auto *sqe = ring_.get_sqe();
+        if (sqe == nullptr) {
+            return false;
+        }
+
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = c.conn->socket().get();
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = buffers_->group();
+        sqe->user_data = user_data(id, op_recv);
+
+        c.pending++;
+        c.receiving = true;
+        return true;
+    }
+
+    void uring_loop::on_accept(const io_uring_cqe &cqe) {
+        if (!(cqe.flags & IORING_CQE_F_MORE) && running_ && !arm_accept()) {
+            logging::net()->critical("Failed to re-arm accept!");
+            running_ = false;
+        }
+
+        if (cqe.res < 0) {
+            logging::net()->error("Accept failed with error {0}!", -cqe.res);
+            return;
+        }
+
+        net::socket socket(cqe.res);
+
+        sockaddr_in address{};
+        socklen_t length = sizeof(address);
+        getpeername(socket.get(), reinterpret_cast<sockaddr *>(&address), &length);
+
+        const net::endpoint endpoint(address);
+
+        // refused sockets are closed right away; not logged, as that is exactly what a flood would want
+        if (!admission().admit(admission().find(endpoint), timers().now())) {
+            return;
+        }
+
+        const auto id = next_connection_id();
+
+        auto &c = clients_[id];
+        c.conn = std::make_unique<connection>(*this, id, std::move(socket), endpoint);
+
+        if (!arm_recv(id, c)) {
+            logging::net()->error("Failed to receive from {0}!", endpoint.to_string());
+            clients_.erase(id);
+            return;
+        }
+
+        logging::net()->info("New connection received from {0}!", endpoint.to_string());
+    }
+
+    void uring_loop::on_recv(const io_uring_cqe &cqe) {
+        const auto id = connection_id(cqe);
+        auto &c = clients_.at(id);
+
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            c.pending--;
+            c.receiving = false;
+        }
+
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            const auto buffer_id = static_cast<std::uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+            if (cqe.res > 0 && !c.closing && !c.conn->on_received(buffers_->data(buffer_id, cqe.res))) {
+                close_client(c);
+            }
+
+            buffers_->recycle(buffer_id);
+        }
+
+        if (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS)) {
+            close_client(c);
+        } else if (!c.receiving && !c.closing && !arm_recv(id, c)) {
+            close_client(c);
+        }
+
+        release_if_done(id);
+    }
+
+    void uring_loop::on_send(const io_uring_cqe &cqe) {
+        const auto id = connection_id(cqe);
+        auto &c = clients_.at(id);
+
+        c.pending--;
+        c.sending = false;
+
+        if (cqe.res > 0) {
+            c.conn->outbound().consume(cqe.res);
+            metrics().bytes_sent.add(cqe.res);
+            metrics().queued_bytes.add(-cqe.res);
+        } else {
+            close_client(c);
+        }
+
+        // resubmit whatever a short send left behind, plus everything queued in the meantime
+        if (!c.closing && !c.dirty && !c.conn->outbound().empty()) {
+            c.dirty = true;
+            dirty_.push_back(id);
+        }
+
+        release_if_done(id);
+    }
+
+    void uring_loop::flush() {
+        std::size_t flushed = 0;
+
+        for (; flushed < dirty_.size(); flushed++) {
+            const auto id = dirty_[flushed];
+            const auto it = clients_.find(id);
+            if (it == clients_.end()) {
+                continue;
+            }
+
+            auto &c = it->second;
+            c.dirty = false;
+
+            if (c.conn->evicted()) {
+                close_client(c);
+            }
+
+            // frames queued while a send is in flight go out with the next one, from its completion
+            if (c.closing || c.sending) {
+                continue;
+            }
+
+            auto &outbound = c.conn->outbound();
+            if (outbound.empty()) {
+                continue;
+            }
+
+            if (outbound.congested() && c.congested_since == std::chrono::steady_clock::time_point{}) {
+                c.congested_since = std::chrono::steady_clock::now();
+                congested_.push_back(id);
+            }
+
+            if (ring_.space_left() == 0) {
+                ring_.submit();
+            }
+
+            // the submission queue is still full; this client and the ones after it stay dirty until the next tick
+            auto *sqe = ring_.get_sqe();
+            if (sqe == nullptr) {
+                c.dirty = true;
+                break;
+            }
+
+            c.message = {};
+            c.message.msg_iov = c.vectors.data();
+            c.message.msg_iovlen = outbound.io_vectors(c.vectors);
+
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->fd = c.conn->socket().get();
+            sqe->addr = reinterpret_cast<std::uint64_t>(&c.message);
+            sqe->len = 1;
+            sqe->msg_flags = MSG_NOSIGNAL;
+            sqe->user_data = user_data(id, op_send);
+
+            c.pending++;
+            c.sending = true;
+        }
+
+        dirty_.erase(dirty_.begin(), dirty_.begin() + static_cast<std::ptrdiff_t>(flushed));
+    }
+
+    void uring_loop::evict_congested() {
+        const auto now = std::chrono::steady_clock::now();
+
+        std::erase_if(congested_, [this, now](std::uint64_t id) {
+            const auto it = clients_.find(id);
+            if (it == clients_.end() || it->second.closing) {
+                return true;
+            }
+
+            auto &c = it->second;
+
+            if (!c.conn->congested()) {
+                c.congested_since = {};
+                return true;
+            }
+
+            if (now - c.congested_since < MAX_CONGESTION_TIME) {
+                return false;
+            }
+
+            logging::net()->warn("Evicting {0}, congested for too long!", c.conn->endpoint().to_string());
+            close_client(c);
+            return true;
+        });
+    }
+
+    void uring_loop::close_client(client &c) {
+        if (c.closing) {
+            return;
+        }
+
+        logging::net()->info("Connection from {0} lost!", c.conn->endpoint().to_string());
+
+        // completes the multishot recv and the pending send, the client is released once they are all back; the
+        // outbound queue has to outlive the send, as the kernel may still be reading from it
+        c.closing = true;
+        ::shutdown(c.conn->socket().get(), SHUT_RDWR);
+    }
+
+    void uring_loop::release_if_done(std::uint64_t id) {
+        const auto it = clients_.find(id);
+        if (it != clients_.end() && it->second.closing && it->second.pending == 0) {
+            clients_.erase(it);
+        }
+    }
+}  // namespace server
+
+#endif
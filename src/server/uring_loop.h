@@ -0,0 +1,135 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#ifdef __linux__
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <net/socket.h>
+#include <net/uring.h>
+
+#include <server/connection.h>
+#include <server/event_loop.h>
+
+namespace server {
+    /**
+     * @brief Completion based event loop on top of io_uring.
+     * @note Accepts with a single multishot accept, receives with one multishot recv per connection into a shared
+     * provided buffer ring, and writes the outbound queue of a connection with a single sendmsg covering every frame
+     * queued since the last one, so that a whole tick of work costs one io_uring_enter call.
+     *
+     * Sends aren't chained with IOSQE_IO_LINK: a short send in a chain cancels the rest of it, leaving the queue to
+     * be rebuilt from whatever did go out. With at most one sendmsg in flight per connection, frames stay in order by
+     * construction, and the remainder of a short send simply goes out with the next one.
+     */
+    struct uring_loop : event_loop {
+        /**
+         * @brief Constructor.
+         * @param shard Index of the loop among the loops of the server.
+         * @param sessions The session table shared by every loop of the server.
+         * @param router The mailboxes of every loop of the server.
+         * @param listener A bound, listening socket.
+         */
+        uring_loop(std::uint32_t shard, session_table &sessions, message_router &router, net::socket listener);
+
+        bool run() override;
+
+        void schedule_flush(connection &conn) override;
+
+    private:
+        enum operation : std::uint8_t {
+            op_accept,
+            op_recv,
+            op_send,
+            op_wake,
+        };
+
+        struct client {
+            std::unique_ptr<connection> conn;
+
+            // describe the outbound queue to the send in flight; must stay put until it completes
+            std::array<net::io_vector, net::gather_list::MAX_VECTORS_PER_WRITE> vectors{};
+            msghdr message{};
+
+            // requests whose completions are still to come; the client can only go away once this reaches zero
+            std::uint32_t pending = 0;
+            bool receiving = false;
+            bool sending = false;
+            bool dirty = false;
+            bool closing = false;
+
+            // when the outbound queue was first seen congested, if it still is
+            std::chrono::steady_clock::time_point congested_since{};
+        };
+
+        // the shard bits of the connection ID don't fit next to the operation, and are the same for every request
+        static constexpr std::uint64_t user_data(std::uint64_t id, operation op) {
+            return ((id & ((std::uint64_t{1} << CONNECTION_ID_SHARD_SHIFT) - 1)) << 8) | op;
+        }
+
+        std::uint64_t connection_id(const io_uring_cqe &cqe) const {
+            return (static_cast<std::uint64_t>(shard()) << CONNECTION_ID_SHARD_SHIFT) | (cqe.user_data >> 8);
+        }
+
+        bool arm_accept();
+
+        bool arm_recv(std::uint64_t id, client &c);
+
+        bool arm_wake();
+
+        void on_accept(const io_uring_cqe &cqe);
+
+        void on_recv(const io_uring_cqe &cqe);
+
+        void on_send(const io_uring_cqe &cqe);
+
+        void flush();
+
+        void evict_congested();
+
+        void close_client(client &c);
+
+        void release_if_done(std::uint64_t id);
+
+        net::socket listener_;
+        std::unordered_map<std::uint64_t, client> clients_;
+        std::vector<std::uint64_t> dirty_;
+        std::vector<std::uint64_t> congested_;
+
+        // the count read off the eventfd of the mailbox; written by the kernel while a read is in flight
+        std::uint64_t wake_count_ = 0;
+
+        // declared last so that the ring is torn down before the buffers it may still be using
+        std::unique_ptr<net::uring_buffer_ring> buffers_;
+        net::uring ring_;
+    };
+}  // namespace server
+
+#endif
@@ -0,0 +1,743 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <metrics/histogram.h>
+
+#include <net/gather_list.h>
+#include <net/outbound_queue.h>
+#include <net/packet.h>
+#include <net/poller.h>
+#include <net/ring_buffer.h>
+#include <net/socket.h>
+#include <net/timing_wheel.h>
+
+#include <net/protocol/ymsg/ymsg_field.h>
+#include <net/protocol/ymsg/ymsg_field_view.h>
+#include <net/protocol/ymsg/ymsg_framer.h>
+#include <net/protocol/ymsg/ymsg_header.h>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace net::protocol;
+
+namespace {
+    using std::chrono::steady_clock;
+
+    // time clients get to collect the responses still in flight when the run ends
+    constexpr std::chrono::seconds DRAIN_TIMEOUT{2};
+
+    // timers are kept in milliseconds
+    constexpr std::chrono::milliseconds TICK{1};
+
+    enum class request : std::uint8_t {
+        helo,
+        login,
+        ping,
+        im,
+        status,
+        count,
+    };
+
+    constexpr std::size_t REQUEST_KINDS = std::size_t(request::count);
+    constexpr std::array<const char *, REQUEST_KINDS> REQUEST_NAMES = {"helo", "login", "ping", "im", "status"};
+
+    /**
+     * @brief Checks whether a frame is the response to a request; frames that aren't, such as pushes from the
+     * server, are counted but not timed.
+     * @param kind The kind of the request.
+     * @param type The type of the received frame.
+     * @return true if the frame answers the request, false otherwise.
+     */
+    bool answers(request kind, YES_ type) {
+        if (type == YES_FEATURE_NOT_SUPPORTED) {
+            return kind != request::ping;
+        }
+
+        switch (kind) {
+            case request::helo:
+                return type == YES_HELO;
+            case request::login:
+                return type == YES_USER_LOGIN_2 || type == YES_USER_LOGIN;
+            case request::status:
+                return type == YES_SET_AWAY_STATUS;
+            default:
+                return false;
+        }
+    }
+
+    struct options {
+        std::string address = "127.0.0.1";
+        std::uint16_t port = 5050;
+
+        std::uint32_t connections = 1000;
+        std::uint32_t threads = 1;
+
+        // new connections per second, over all threads; 0 opens them as fast as possible
+        std::uint32_t connect_rate = 1000;
+
+        // frames per second of every logged in connection
+        double rate = 1.0;
+        std::chrono::seconds duration{10};
+
+        // relative weights of the traffic after login
+        std::array<std::uint32_t, REQUEST_KINDS> weights{0, 0, 1, 8, 1};
+        std::size_t message_size = 64;
+    };
+
+    void print_usage(const char *program) {
+        std::printf("Usage: %s [options]\n", program);
+        std::printf("Opens many connections to a server, logs every one of them in, then sends a mix of frames at a\n");
+        std::printf("steady rate, and reports throughput and response latency per message type.\n");
+        std::printf("  --address <ip>         address of the server (default: 127.0.0.1)\n");
+        std::printf("  --port <port>          port of the server (default: 5050)\n");
+        std::printf("  --connections <count>  concurrent connections (default: 1000)\n");
+        std::printf("  --connect-rate <n>     new connections per second, 0 for no limit (default: 1000)\n");
+        std::printf("  --rate <n>             frames per second of every connection once logged in (default: 1)\n");
+        std::printf("  --duration <seconds>   length of the run, connecting included (default: 10)\n");
+        std::printf("  --mix <weights>        traffic mix, as in ping=1,im=8,status=1 (default)\n");
+        std::printf("  --message-size <bytes> length of instant messages (default: 64)\n");
+        std::printf("Instant messages go to random connections of the run, and are timed until they are delivered.\n");
+        std::printf("  --threads <count>      client threads, each with its share of the connections (default: 1)\n");
+        std::printf("  --help                 show this message\n");
+    }
+
+    template<typename T>
+    bool parse_number(std::string_view text, T &value) {
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() && end == text.data() + text.size();
+    }
+
+    bool parse_mix(std::string_view spec, std::array<std::uint32_t, REQUEST_KINDS> &weights) {
+        std::array<std::uint32_t, REQUEST_KINDS> result{};
+
+        while (!spec.empty()) {
+            const auto end = std::min(spec.find(','), spec.size());
+            const auto item = spec.substr(0, end);
+            spec.remove_prefix(std::min(end + 1, spec.size()));
+
+            const auto equals = item.find('=');
+            if (equals == std::string_view::npos) {
+                return false;
+            }
+
+            const auto name = item.substr(0, equals);
+            const auto kind = std::ranges::find(REQUEST_NAMES, name);
+
+            // the handshake isn't part of the mix
+            if (kind == REQUEST_NAMES.end() || kind - REQUEST_NAMES.begin() < std::ptrdiff_t(request::ping) ||
+                !parse_number(item.substr(equals + 1), result[kind - REQUEST_NAMES.begin()])) {
+                return false;
+            }
+        }
+
+        if (std::ranges::all_of(result, [](std::uint32_t weight) { return weight == 0; })) {
+            return false;
+        }
+
+        weights = result;
+        return true;
+    }
+
+    std::optional<options> parse_arguments(int argc, char **argv) {
+        options result;
+
+        for (int i = 1; i < argc; i++) {
+            const std::string_view option = argv[i];
+
+            if (option == "--help") {
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+                return std::nullopt;
+            }
+
+            const std::string_view value = argv[++i];
+            auto valid = true;
+
+            if (option == "--address") {
+                result.address = value;
+            } else if (option == "--port") {
+                valid = parse_number(value, result.port);
+            } else if (option == "--connections") {
+                valid = parse_number(value, result.connections) && result.connections > 0;
+            } else if (option == "--connect-rate") {
+                valid = parse_number(value, result.connect_rate);
+            } else if (option == "--rate") {
+                valid = parse_number(value, result.rate) && result.rate > 0;
+            } else if (option == "--duration") {
+                std::uint32_t seconds = 0;
+                valid = parse_number(value, seconds) && seconds > 0;
+                result.duration = std::chrono::seconds(seconds);
+            } else if (option == "--mix") {
+                valid = parse_mix(value, result.weights);
+            } else if (option == "--message-size") {
+                valid = parse_number(value, result.message_size) && result.message_size > 0;
+            } else if (option == "--threads") {
+                valid = parse_number(value, result.threads) && result.threads > 0;
+            } else {
+                std::fprintf(stderr, "Unknown option: %s\n", argv[i - 1]);
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+
+            if (!valid) {
+                std::fprintf(stderr, "Invalid value for %s: %s\n", argv[i - 1], argv[i]);
+                return std::nullopt;
+            }
+        }
+
+        result.threads = std::min(result.threads, result.connections);
+        return result;
+    }
+
+    /**
+     * @brief Encodes a frame with the header and field encoders of the server.
+     */
+    net::gather_list encode(YES_ type, std::initializer_list<std::pair<YMSG_FLD_, std::string_view>> fields) {
+        net::serializer body;
+        for (const auto &[key, value]: fields) {
+            body.emplace<ymsg_field>(key, value);
+        }
+
+        net::gather_list frame;
+        frame.emplace<ymsg_header>(16, 0, static_cast<std::uint16_t>(body.data().size()), type, YES_STATUS_OK, 0);
+        frame.append(std::move(body));
+        return frame;
+    }
+
+    struct worker_stats {
+        std::uint64_t connecting = 0;
+        std::uint64_t connected = 0;
+        std::uint64_t logged_in = 0;
+        std::uint64_t failed = 0;
+        std::uint64_t closed_by_server = 0;
+
+        std::uint64_t frames_sent = 0;
+        std::uint64_t frames_received = 0;
+        std::uint64_t unanswered = 0;
+        std::uint64_t undelivered = 0;
+        std::array<std::uint64_t, REQUEST_KINDS> sent{};
+
+        // from the first connect to the last connection established
+        std::optional<steady_clock::time_point> first_connect;
+        steady_clock::time_point last_connected;
+
+        std::array<metrics::histogram, REQUEST_KINDS> latency;
+    };
+
+    /**
+     * @brief Drives its share of the connections from one thread, with non-blocking sockets and a poller of its
+     * own, the way the server does.
+     */
+    struct worker {
+        worker(const options &opts, std::uint32_t first, std::uint32_t count, std::uint64_t seed)
+          : opts_(opts),
+            first_(first),
+            count_(count),
+            random_(seed),
+            mix_(opts.weights.begin(), opts.weights.end()),
+            server_(opts.address, opts.port) {}
+
+        worker(const worker &) = delete;
+        worker &operator=(const worker &) = delete;
+
+        void run() {
+            if (!poller_.is_valid()) {
+                std::fprintf(stderr, "Failed to create a poller!\n");
+                return;
+            }
+
+            clients_.reserve(count_);
+            started_ = steady_clock::now();
+
+            const auto stop_sending = started_ + opts_.duration;
+            const auto interval = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(1000.0 / opts_.rate));
+            std::uniform_int_distribution<std::uint64_t> phase(0, interval - 1);
+
+            std::array<net::poller::event, 1024> events{};
+
+            while (true) {
+                const auto now = steady_clock::now();
+                sending_ = now < stop_sending;
+
+                if (!sending_ && (now >= stop_sending + DRAIN_TIMEOUT || waiting() == 0)) {
+                    break;
+                }
+
+                if (sending_) {
+                    open_connections(now);
+                }
+
+                const auto count = poller_.wait(events, 1);
+
+                for (std::int32_t i = 0; i < count; i++) {
+                    auto &c = *static_cast<client *>(events[i].data);
+                    if (c.state == stage::closed) {
+                        continue;
+                    }
+
+                    if (events[i].events & net::poller::error) {
+                        fail(c);
+                        continue;
+                    }
+
+                    if (c.state == stage::connecting && !on_connected(c)) {
+                        continue;
+                    }
+
+                    if ((events[i].events & net::poller::readable) && !on_readable(c, phase)) {
+                        continue;
+                    }
+
+                    flush(c);
+                }
+
+                wheel_.advance(current_tick(), [&](net::timer &t) {
+                    auto &c = *static_cast<client *>(t.data());
+                    if (c.state != stage::active || !sending_) {
+                        return;
+                    }
+
+                    send_traffic(c);
+                    wheel_.schedule(c.send_timer, wheel_.now() + interval);
+                });
+            }
+
+            for (auto &c: clients_) {
+                stats_.unanswered += c->pending.size();
+            }
+
+            clients_.clear();
+        }
+
+        const worker_stats &stats() const {
+            return stats_;
+        }
+
+    private:
+        enum class stage : std::uint8_t {
+            connecting,
+            greeting,
+            logging_in,
+            active,
+            closed,
+        };
+
+        struct client {
+            net::socket socket;
+            std::string username;
+            stage state = stage::connecting;
+
+            net::ring_buffer received;
+            net::protocol::ymsg_framer framer;
+            net::outbound_queue outbound;
+
+            // the body of a received message whose frame wraps around the end of the ring buffer
+            std::vector<std::byte> wrapped_body;
+
+            // requests still waiting for their response, oldest first
+            std::deque<std::pair<request, steady_clock::time_point>> pending;
+            net::timer send_timer{this};
+        };
+
+        std::uint64_t current_tick() const {
+            return (steady_clock::now() - started_) / TICK;
+        }
+
+        std::size_t waiting() const {
+            return std::ranges::count_if(clients_, [](const auto &c) {
+                return c->state != stage::closed && !c->pending.empty();
+            });
+        }
+
+        void open_connections(steady_clock::time_point now) {
+            auto allowed = static_cast<std::uint64_t>(count_);
+            if (opts_.connect_rate != 0) {
+                const auto per_worker = std::max(1.0, static_cast<double>(opts_.connect_rate) / opts_.threads);
+                const auto elapsed = std::chrono::duration<double>(now - started_).count();
+                allowed = std::min(allowed, static_cast<std::uint64_t>(per_worker * elapsed) + 1);
+            }
+
+            while (clients_.size() < allowed) {
+                auto &c = *clients_.emplace_back(std::make_unique<client>());
+                c.username = "loadgen_" + std::to_string(first_ + clients_.size() - 1);
+
+                stats_.connecting++;
+                if (!stats_.first_connect) {
+                    stats_.first_connect = now;
+                }
+
+                c.socket = net::socket(net::socket::stream);
+                if (!c.socket.is_valid() || !c.socket.set_non_blocking()) {
+                    fail(c);
+                    continue;
+                }
+
+                if (!c.socket.connect(server_) && errno != EINPROGRESS) {
+                    fail(c);
+                    continue;
+                }
+
+                if (!poller_.add(c.socket.get(), net::poller::readable | net::poller::writable, &c)) {
+                    fail(c);
+                }
+            }
+        }
+
+        bool on_connected(client &c) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+
+            if (::getsockopt(c.socket.get(), SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+                fail(c);
+                return false;
+            }
+
+            stats_.connected++;
+            stats_.last_connected = steady_clock::now();
+
+            c.state = stage::greeting;
+            send(c, request::helo, encode(YES_HELO, {{YMSG_FLD_CURRENT_ID, c.username}}));
+            return true;
+        }
+
+        template<typename Phase>
+        bool on_readable(client &c, Phase &phase) {
+            while (true) {
+                const auto status = c.socket.read(c.received);
+
+                const auto [first, second] = c.received.readable();
+                net::deserializer data(first, second);
+                const auto buffered = data.size();
+
+                ymsg_header header;
+                net::deserializer body({});
+
+                while (c.framer.next(data, header, body) == ymsg_framer::result::frame) {
+                    on_frame(c, header, body, phase);
+                }
+
+                c.received.consume(buffered - data.size());
+
+                if (status == net::socket::read_status::closed) {
+                    stats_.closed_by_server++;
+                    close(c);
+                    return false;
+                }
+
+                if (status == net::socket::read_status::drained) {
+                    return c.state != stage::closed;
+                }
+            }
+        }
+
+        template<typename Phase>
+        void on_frame(client &c, const ymsg_header &header, const net::deserializer &body, Phase &phase) {
+            stats_.frames_received++;
+
+            if (header.type == YES_USER_HAS_MSG || header.type == YES_USER_SEND_MESG) {
+                on_message(c, header, body);
+                return;
+            }
+
+            if (c.pending.empty() || !answers(c.pending.front().first, header.type)) {
+                return;
+            }
+
+            const auto [kind, sent_at] = c.pending.front();
+            c.pending.pop_front();
+
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(steady_clock::now() - sent_at);
+            stats_.latency[std::size_t(kind)].record(elapsed.count());
+
+            if (kind == request::helo && c.state == stage::greeting) {
+                c.state = stage::logging_in;
+                send(c, request::login,
+                     encode(YES_USER_LOGIN_2, {{YMSG_FLD_CURRENT_ID, c.username},
+                                               {YMSG_FLD_LOGIN_Y_COOKIE, "v=1&n=loadgen"},
+                                               {YMSG_FLD_LOGIN_T_COOKIE, "z=loadgen"},
+                                               {YMSG_FLD_CRUMB_HASH, "loadgen"},
+                                               {YMSG_FLD_COUNTRY_CODE, "us"},
+                                               {YMSG_FLD_VERSION, "9.0.0.2162"}}));
+            } else if (kind == request::login && c.state == stage::logging_in) {
+                // spread the traffic of the connections over the whole interval
+                stats_.logged_in++;
+                c.state = stage::active;
+                wheel_.schedule(c.send_timer, current_tick() + 1 + phase(random_));
+            }
+        }
+
+        /**
+         * @brief Times a delivered instant message by the send time at the start of its text, or counts a bounce.
+         */
+        void on_message(client &c, const ymsg_header &header, const net::deserializer &body) {
+            if (header.status != YES_STATUS_NOTIFY) {
+                stats_.undelivered++;
+                return;
+            }
+
+            const auto text =
+                    ymsg_frame_view(body.contiguous(c.wrapped_body)).find(YMSG_FLD_MSG).value_or(std::string_view());
+
+            std::int64_t sent_at = 0;
+            if (std::from_chars(text.data(), text.data() + text.size(), sent_at).ec != std::errc()) {
+                return;
+            }
+
+            const auto now = steady_clock::now().time_since_epoch();
+            stats_.latency[std::size_t(request::im)].record(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now).count() - sent_at);
+        }
+
+        void send_traffic(client &c) {
+            switch (static_cast<request>(mix_(random_))) {
+                case request::ping:
+                    send(c, request::ping, encode(YES_PING, {}));
+                    break;
+                case request::im: {
+                    // to any connection of the run, which may be served by another thread of the server
+                    std::uniform_int_distribution<std::uint32_t> target(0, opts_.connections - 1);
+
+                    const auto now = steady_clock::now().time_since_epoch();
+                    auto text = std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+                    text += ' ';
+                    text.resize(std::max(text.size(), opts_.message_size), 'x');
+
+                    send(c, request::im,
+                         encode(YES_USER_HAS_MSG, {{YMSG_FLD_CURRENT_ID, c.username},
+                                                   {YMSG_FLD_TARGET_USER, "loadgen_" + std::to_string(target(random_))},
+                                                   {YMSG_FLD_MSG, text},
+                                                   {YMSG_FLD_UTF8_FLAG, "1"}}));
+                    break;
+                }
+                case request::status:
+                    send(c, request::status, encode(YES_SET_AWAY_STATUS, {{YMSG_FLD_AWAY_STATUS, "2"}}));
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void send(client &c, request kind, net::gather_list &&frame) {
+            c.outbound.push(std::move(frame));
+            stats_.frames_sent++;
+            stats_.sent[std::size_t(kind)]++;
+
+            // pings are never answered, and instant messages are timed where they are delivered
+            if (kind != request::ping && kind != request::im) {
+                c.pending.emplace_back(kind, steady_clock::now());
+            }
+
+            flush(c);
+        }
+
+        void flush(client &c) {
+            while (c.state != stage::closed && c.state != stage::connecting && !c.outbound.empty()) {
+                if (c.outbound.send(c.socket) > 0 || net::impl::interrupted()) {
+                    continue;
+                }
+
+                // the rest goes out on the next writable event
+                if (!net::impl::would_block()) {
+                    stats_.closed_by_server++;
+                    close(c);
+                }
+
+                return;
+            }
+        }
+
+        void fail(client &c) {
+            stats_.failed++;
+            close(c);
+        }
+
+        void close(client &c) {
+            if (c.socket.is_valid()) {
+                poller_.remove(c.socket.get());
+                c.socket.close();
+            }
+
+            c.state = stage::closed;
+            c.send_timer.cancel();
+            stats_.unanswered += c.pending.size();
+            c.pending.clear();
+        }
+
+        const options &opts_;
+        std::uint32_t first_;
+        std::uint32_t count_;
+
+        std::mt19937_64 random_;
+        std::discrete_distribution<std::size_t> mix_;
+
+        net::endpoint server_;
+        net::poller poller_;
+        net::timing_wheel wheel_;
+        steady_clock::time_point started_;
+        bool sending_ = true;
+
+        std::vector<std::unique_ptr<client>> clients_;
+        worker_stats stats_;
+    };
+
+    /**
+     * @brief Lifts the limit on open files as far as allowed, since every connection takes a descriptor.
+     */
+    void raise_file_limit() {
+        rlimit limit{};
+        if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    double milliseconds(std::uint64_t nanoseconds) {
+        return static_cast<double>(nanoseconds) / 1e6;
+    }
+}  // namespace
+
+int32_t main(int32_t argc, char **argv) {
+    const auto opts = parse_arguments(argc, argv);
+    if (!opts.has_value()) {
+        return EXIT_FAILURE;
+    }
+
+    raise_file_limit();
+    net::impl::impl_init();
+
+    std::vector<std::unique_ptr<worker>> workers;
+    for (std::uint32_t i = 0, first = 0; i < opts->threads; i++) {
+        const auto count = opts->connections / opts->threads + (i < opts->connections % opts->threads ? 1 : 0);
+        workers.push_back(std::make_unique<worker>(*opts, first, count, std::random_device()()));
+        first += count;
+    }
+
+    std::printf("Opening %u connections to %s:%u from %u thread(s) for %lld s...\n", opts->connections,
+                opts->address.c_str(), opts->port, opts->threads, (long long) opts->duration.count());
+
+    const auto started = steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (auto &w: workers) {
+        threads.emplace_back([&w] { w->run(); });
+    }
+
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    const auto elapsed = std::chrono::duration<double>(steady_clock::now() - started).count();
+
+    worker_stats totals;
+    std::array<metrics::histogram_snapshot, REQUEST_KINDS> latency;
+    std::optional<steady_clock::time_point> first_connect;
+
+    for (const auto &w: workers) {
+        const auto &s = w->stats();
+
+        totals.connecting += s.connecting;
+        totals.connected += s.connected;
+        totals.logged_in += s.logged_in;
+        totals.failed += s.failed;
+        totals.closed_by_server += s.closed_by_server;
+        totals.frames_sent += s.frames_sent;
+        totals.frames_received += s.frames_received;
+        totals.unanswered += s.unanswered;
+        totals.undelivered += s.undelivered;
+
+        for (std::size_t i = 0; i < REQUEST_KINDS; i++) {
+            totals.sent[i] += s.sent[i];
+            latency[i].add(s.latency[i]);
+        }
+
+        if (s.first_connect && (!first_connect || *s.first_connect < *first_connect)) {
+            first_connect = s.first_connect;
+        }
+
+        totals.last_connected = std::max(totals.last_connected, s.last_connected);
+    }
+
+    const auto connecting_time =
+            first_connect ? std::chrono::duration<double>(totals.last_connected - *first_connect).count() : 0.0;
+
+    std::printf("Connections: %llu of %llu established in %.3f s (%.0f/s), %llu logged in, %llu failed, "
+                "%llu closed by the server\n",
+                (unsigned long long) totals.connected, (unsigned long long) totals.connecting, connecting_time,
+                connecting_time > 0 ? static_cast<double>(totals.connected) / connecting_time : 0.0,
+                (unsigned long long) totals.logged_in, (unsigned long long) totals.failed,
+                (unsigned long long) totals.closed_by_server);
+
+    std::printf("Frames: %llu sent (%.0f/s), %llu received (%.0f/s) in %.3f s, %llu requests unanswered\n",
+                (unsigned long long) totals.frames_sent, static_cast<double>(totals.frames_sent) / elapsed,
+                (unsigned long long) totals.frames_received, static_cast<double>(totals.frames_received) / elapsed,
+                elapsed, (unsigned long long) totals.unanswered);
+
+    if (totals.sent[std::size_t(request::im)] > 0) {
+        std::printf("Instant messages: %llu delivered, %llu bounced\n",
+                    (unsigned long long) latency[std::size_t(request::im)].count,
+                    (unsigned long long) totals.undelivered);
+    }
+
+    std::printf("\n%-8s %10s %10s %10s %10s %10s %10s %10s\n", "type", "sent", "answered", "p50 ms", "p90 ms",
+                "p99 ms", "p99.9 ms", "max ms");
+
+    for (std::size_t i = 0; i < REQUEST_KINDS; i++) {
+        if (totals.sent[i] == 0) {
+            continue;
+        }
+
+        const auto &l = latency[i];
+        if (l.count == 0) {
+            std::printf("%-8s %10llu %10d %10s %10s %10s %10s %10s\n", REQUEST_NAMES[i],
+                        (unsigned long long) totals.sent[i], 0, "-", "-", "-", "-", "-");
+            continue;
+        }
+
+        std::printf("%-8s %10llu %10llu %10.3f %10.3f %10.3f %10.3f %10.3f\n", REQUEST_NAMES[i],
+                    (unsigned long long) totals.sent[i], (unsigned long long) l.count,
+                    milliseconds(l.value_at(0.5)), milliseconds(l.value_at(0.9)), milliseconds(l.value_at(0.99)),
+                    milliseconds(l.value_at(0.999)), milliseconds(l.value_at(1.0)));
+    }
+
+    net::impl::impl_cleanup();
+    return totals.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
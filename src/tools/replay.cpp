@@ -0,0 +1,556 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <capture/format.h>
+
+#include <net/socket.h>
+
+#include <net/protocol/ymsg/ymsg_field_view.h>
+#include <net/protocol/ymsg/ymsg_framer.h>
+#include <net/protocol/ymsg/ymsg_header.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    using std::chrono::steady_clock;
+
+    // time the server gets to answer the last frames of the capture
+    constexpr std::chrono::seconds DRAIN_TIMEOUT{2};
+
+    // mismatches reported in detail; the rest are only counted
+    constexpr std::size_t MAX_REPORTED_MISMATCHES = 10;
+
+    struct options {
+        std::string address = "127.0.0.1";
+        std::uint16_t port = 5050;
+
+        // how much faster than recorded to replay; 0 replays as fast as possible
+        double speed = 1.0;
+        bool verify = true;
+
+        std::vector<std::string> captures;
+    };
+
+    void print_usage(const char *program) {
+        std::printf("Usage: %s [options] <capture>...\n", program);
+        std::printf("Re-drives the client traffic of captures recorded with --capture against a server; the files\n");
+        std::printf("of every thread of a capture are merged by time.\n");
+        std::printf("  --address <ip>         address of the server (default: 127.0.0.1)\n");
+        std::printf("  --port <port>          port of the server (default: 5050)\n");
+        std::printf("  --speed <factor|max>   replay speed relative to the capture (default: 1)\n");
+        std::printf("  --no-verify            don't compare the responses with the recorded ones\n");
+        std::printf("  --help                 show this message\n");
+    }
+
+    template<typename T>
+    bool parse_number(std::string_view text, T &value) {
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() && end == text.data() + text.size();
+    }
+
+    std::optional<options> parse_arguments(int argc, char **argv) {
+        options result;
+
+        for (int i = 1; i < argc; i++) {
+            const std::string_view option = argv[i];
+
+            if (option == "--help") {
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+
+            if (option == "--no-verify") {
+                result.verify = false;
+                continue;
+            }
+
+            if (!option.starts_with("--")) {
+                result.captures.emplace_back(option);
+                continue;
+            }
+
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+                return std::nullopt;
+            }
+
+            const std::string_view value = argv[++i];
+
+            if (option == "--address") {
+                result.address = value;
+            } else if (option == "--port") {
+                if (!parse_number(value, result.port)) {
+                    std::fprintf(stderr, "Invalid port: %s\n", argv[i]);
+                    return std::nullopt;
+                }
+            } else if (option == "--speed") {
+                if (value == "max") {
+                    result.speed = 0;
+                } else if (!parse_number(value, result.speed) || result.speed <= 0) {
+                    std::fprintf(stderr, "Invalid speed: %s\n", argv[i]);
+                    return std::nullopt;
+                }
+            } else {
+                std::fprintf(stderr, "Unknown option: %s\n", argv[i - 1]);
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+        }
+
+        if (result.captures.empty()) {
+            print_usage(argv[0]);
+            return std::nullopt;
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief A capture file mapped into memory.
+     */
+    struct mapped_file {
+        explicit mapped_file(const std::string &path) {
+            const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+
+            struct stat info{};
+            if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+                auto *data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED) {
+                    data_ = std::span(static_cast<const std::byte *>(data), info.st_size);
+                }
+            }
+
+            ::close(fd);
+        }
+
+        ~mapped_file() {
+            if (!data_.empty()) {
+                ::munmap(const_cast<std::byte *>(data_.data()), data_.size());
+            }
+        }
+
+        mapped_file(const mapped_file &) = delete;
+        mapped_file &operator=(const mapped_file &) = delete;
+
+        std::span<const std::byte> data() const {
+            return data_;
+        }
+
+    private:
+        std::span<const std::byte> data_;
+    };
+
+    /**
+     * @brief What responses are compared by: their type, status and the keys of their fields, in order. Values
+     * are left out, since challenges, session IDs and the like differ from run to run.
+     */
+    struct frame_shape {
+        net::protocol::YES_ type;
+        net::protocol::YES_STATUS_ status;
+        std::vector<std::uint16_t> keys;
+
+        bool operator==(const frame_shape &) const = default;
+
+        std::string to_string() const {
+            auto result = "type " + std::to_string(type) + " status " + std::to_string(status) + " keys [";
+
+            for (std::size_t i = 0; i < keys.size(); i++) {
+                result += (i == 0 ? "" : ",") + std::to_string(keys[i]);
+            }
+
+            return result + "]";
+        }
+    };
+
+    frame_shape shape_of(const net::protocol::ymsg_header &header, std::span<const std::byte> body) {
+        frame_shape shape{header.type, header.status, {}};
+
+        for (const auto &field: net::protocol::ymsg_frame_view(body)) {
+            shape.keys.push_back(field.key);
+        }
+
+        return shape;
+    }
+
+    std::optional<frame_shape> shape_of(std::span<const std::byte> frame) {
+        net::deserializer data(frame);
+        net::protocol::ymsg_header header;
+
+        if (!header.deserialize(data) || data.size() < header.length) {
+            return std::nullopt;
+        }
+
+        return shape_of(header, frame.subspan(frame.size() - data.size(), header.length));
+    }
+
+    /**
+     * @brief A recorded client connection, as replayed.
+     */
+    struct session {
+        net::socket socket;
+        bool connected = false;
+
+        // set once the capture says the connection ended; closed as soon as no more responses are expected
+        bool ending = false;
+        bool done = false;
+
+        std::vector<std::byte> received;
+        net::protocol::ymsg_framer framer;
+
+        // shapes of the responses recorded for this connection, oldest first
+        std::deque<frame_shape> expected;
+    };
+
+    struct totals {
+        std::uint64_t sent = 0;
+        std::uint64_t failed_connects = 0;
+        std::uint64_t matched = 0;
+        std::uint64_t mismatched = 0;
+        std::uint64_t unexpected = 0;
+        std::uint64_t missing = 0;
+    };
+
+    struct replay {
+        replay(const options &opts, std::unordered_map<std::uint64_t, session> &sessions)
+          : opts_(opts), sessions_(sessions), server_(opts.address, opts.port) {}
+
+        void send(std::uint64_t id, session &s, std::span<const std::byte> frame) {
+            if (s.done) {
+                return;
+            }
+
+            if (!s.connected) {
+                s.socket = net::socket(net::socket::stream);
+                if (!s.socket.connect(server_) || !s.socket.set_non_blocking()) {
+                    std::fprintf(stderr, "Failed to connect for connection %llu!\n", (unsigned long long) id);
+                    totals_.failed_connects++;
+                    s.done = true;
+                    return;
+                }
+
+                s.connected = true;
+            }
+
+            while (!frame.empty()) {
+                const auto written = s.socket.write_raw(frame.data(), frame.size());
+
+                if (written > 0) {
+                    frame = frame.subspan(written);
+                    continue;
+                }
+
+                if (written < 0 && (net::impl::would_block() || net::impl::interrupted())) {
+                    // the server is behind; take its responses off the socket while waiting for room
+                    pollfd fd{s.socket.get(), POLLOUT, 0};
+                    ::poll(&fd, 1, 100);
+                    pump(steady_clock::now());
+                    continue;
+                }
+
+                close(s);
+                return;
+            }
+
+            totals_.sent++;
+        }
+
+        /**
+         * @brief Reads responses until the deadline.
+         * @param deadline When to return; returns after one poll if it already passed.
+         */
+        void pump(steady_clock::time_point deadline) {
+            std::vector<pollfd> fds;
+            std::vector<session *> owners;
+
+            do {
+                fds.clear();
+                owners.clear();
+
+                for (auto &[id, s]: sessions_) {
+                    if (s.connected && !s.done) {
+                        fds.push_back({s.socket.get(), POLLIN, 0});
+                        owners.push_back(&s);
+                    }
+                }
+
+                const auto remaining =
+                        std::chrono::ceil<std::chrono::milliseconds>(deadline - steady_clock::now()).count();
+                const auto timeout = static_cast<int>(std::clamp<std::int64_t>(remaining, 0, 100));
+
+                if (::poll(fds.data(), fds.size(), timeout) <= 0) {
+                    continue;
+                }
+
+                for (std::size_t i = 0; i < fds.size(); i++) {
+                    if (fds[i].revents != 0) {
+                        on_readable(*owners[i]);
+                    }
+                }
+            } while (steady_clock::now() < deadline);
+        }
+
+        void on_readable(session &s) {
+            std::array<std::byte, 16 * 1024> buffer{};
+
+            while (true) {
+                const auto bytes_read = s.socket.read_raw(buffer.data(), buffer.size());
+
+                if (bytes_read > 0) {
+                    s.received.insert(s.received.end(), buffer.begin(), buffer.begin() + bytes_read);
+                    continue;
+                }
+
+                if (bytes_read < 0 && net::impl::interrupted()) {
+                    continue;
+                }
+
+                if (bytes_read < 0 && net::impl::would_block()) {
+                    break;
+                }
+
+                // the server hung up
+                take_frames(s);
+                close(s);
+                return;
+            }
+
+            take_frames(s);
+
+            if (s.ending && s.expected.empty()) {
+                close(s);
+            }
+        }
+
+        void take_frames(session &s) {
+            net::deserializer data(s.received);
+            net::protocol::ymsg_header header;
+            net::deserializer body({});
+
+            while (s.framer.next(data, header, body) == net::protocol::ymsg_framer::result::frame) {
+                std::vector<std::byte> scratch;
+                check(s, shape_of(header, body.contiguous(scratch)));
+            }
+
+            s.received.erase(s.received.begin(), s.received.end() - static_cast<std::ptrdiff_t>(data.size()));
+        }
+
+        void check(session &s, const frame_shape &actual) {
+            if (!opts_.verify) {
+                return;
+            }
+
+            if (s.expected.empty()) {
+                totals_.unexpected++;
+                report("unexpected response", nullptr, actual);
+                return;
+            }
+
+            if (s.expected.front() == actual) {
+                totals_.matched++;
+            } else {
+                totals_.mismatched++;
+                report("mismatched response", &s.expected.front(), actual);
+            }
+
+            s.expected.pop_front();
+        }
+
+        void report(const char *what, const frame_shape *expected, const frame_shape &actual) {
+            if (reported_++ >= MAX_REPORTED_MISMATCHES) {
+                return;
+            }
+
+            std::fprintf(stderr, "%s: expected %s, got %s\n", what,
+                         expected != nullptr ? expected->to_string().c_str() : "nothing", actual.to_string().c_str());
+        }
+
+        void close(session &s) {
+            if (s.connected) {
+                s.socket.close();
+            }
+
+            s.done = true;
+        }
+
+        /**
+         * @brief Waits for the last responses, then closes every connection.
+         */
+        void finish() {
+            const auto deadline = steady_clock::now() + DRAIN_TIMEOUT;
+
+            const auto waiting = [this] {
+                return std::ranges::any_of(sessions_, [](const auto &entry) {
+                    return !entry.second.done && !entry.second.expected.empty();
+                });
+            };
+
+            while (opts_.verify && waiting() && steady_clock::now() < deadline) {
+                pump(std::min(deadline, steady_clock::now() + std::chrono::milliseconds(100)));
+            }
+
+            for (auto &[id, s]: sessions_) {
+                totals_.missing += s.expected.size();
+                close(s);
+            }
+        }
+
+        const totals &result() const {
+            return totals_;
+        }
+
+    private:
+        const options &opts_;
+        std::unordered_map<std::uint64_t, session> &sessions_;
+        net::endpoint server_;
+        totals totals_;
+        std::size_t reported_ = 0;
+    };
+}  // namespace
+
+int32_t main(int32_t argc, char **argv) {
+    const auto opts = parse_arguments(argc, argv);
+    if (!opts.has_value()) {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::unique_ptr<mapped_file>> files;
+    std::vector<capture::record> records;
+
+    for (const auto &path: opts->captures) {
+        auto &file = files.emplace_back(std::make_unique<mapped_file>(path));
+
+        capture::record_cursor cursor(file->data());
+        if (cursor.header() == nullptr) {
+            std::fprintf(stderr, "%s is not a capture file!\n", path.c_str());
+            return EXIT_FAILURE;
+        }
+
+        while (const auto r = cursor.next()) {
+            records.push_back(*r);
+        }
+    }
+
+    std::ranges::stable_sort(records, {}, [](const capture::record &r) { return r.header->timestamp; });
+
+    if (records.empty()) {
+        std::fprintf(stderr, "The captures hold no records!\n");
+        return EXIT_FAILURE;
+    }
+
+    net::impl::impl_init();
+
+    // the recorded responses of a connection are known up front, so responses that arrive early still match
+    std::unordered_map<std::uint64_t, session> sessions;
+    std::uint64_t inbound = 0;
+
+    for (const auto &r: records) {
+        auto &s = sessions[r.header->connection_id];
+
+        if (r.header->dir == capture::direction::inbound) {
+            inbound++;
+        } else if (r.header->dir == capture::direction::outbound && opts->verify) {
+            if (auto shape = shape_of(r.frame)) {
+                s.expected.push_back(std::move(*shape));
+            }
+        }
+    }
+
+    replay player(*opts, sessions);
+
+    const auto first_timestamp = records.front().header->timestamp;
+    const auto started = steady_clock::now();
+
+    for (const auto &r: records) {
+        if (opts->speed > 0) {
+            const auto elapsed = static_cast<double>(r.header->timestamp - first_timestamp);
+            const auto offset = std::chrono::nanoseconds(static_cast<std::int64_t>(elapsed / opts->speed));
+            player.pump(started + offset);
+        } else {
+            player.pump(steady_clock::now());
+        }
+
+        auto &s = sessions.at(r.header->connection_id);
+
+        switch (r.header->dir) {
+            case capture::direction::inbound:
+                player.send(r.header->connection_id, s, r.frame);
+                break;
+            case capture::direction::outbound:
+                break;
+            case capture::direction::closed:
+                s.ending = true;
+                if (s.expected.empty()) {
+                    player.close(s);
+                }
+                break;
+        }
+    }
+
+    const auto replayed_in = std::chrono::duration<double>(steady_clock::now() - started).count();
+    player.finish();
+
+    const auto &result = player.result();
+    std::printf("Replayed %llu frames of %zu connections in %.3f s (%.0f frames/s)\n",
+                (unsigned long long) result.sent, sessions.size(), replayed_in,
+                replayed_in > 0 ? static_cast<double>(result.sent) / replayed_in : 0.0);
+
+    if (result.sent != inbound) {
+        std::printf("%llu of %llu recorded frames could not be sent; %llu connections failed\n",
+                    (unsigned long long) (inbound - result.sent), (unsigned long long) inbound,
+                    (unsigned long long) result.failed_connects);
+    }
+
+    net::impl::impl_cleanup();
+
+    if (!opts->verify) {
+        return result.failed_connects == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::printf("Responses: %llu matched, %llu mismatched, %llu unexpected, %llu missing\n",
+                (unsigned long long) result.matched, (unsigned long long) result.mismatched,
+                (unsigned long long) result.unexpected, (unsigned long long) result.missing);
+
+    const auto clean = result.failed_connects == 0 && result.mismatched == 0 && result.unexpected == 0 &&
+                       result.missing == 0;
+    return clean ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,128 @@
+// MIT License
+//
+// Copyright (c) 2024 r0neko, pushfq
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <capture/trace.h>
+
+#include <server/flight_recorder.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+namespace {
+    struct trace_file {
+        capture::trace_header header;
+        std::vector<capture::trace_span> spans;
+    };
+
+    void print_usage(const char *program) {
+        std::printf("Usage: %s <trace>...\n", program);
+        std::printf("Converts traces recorded with --trace into Chrome trace JSON on the standard output, for\n");
+        std::printf("chrome://tracing or Perfetto; every thread becomes a process and every connection a thread.\n");
+    }
+
+    bool read_trace(const char *path, trace_file &file) {
+        auto *stream = std::fopen(path, "rb");
+        if (stream == nullptr) {
+            std::fprintf(stderr, "Failed to open %s!\n", path);
+            return false;
+        }
+
+        auto ok = std::fread(&file.header, sizeof(file.header), 1, stream) == 1 &&
+                  file.header.magic == capture::TRACE_MAGIC;
+
+        if (!ok) {
+            std::fprintf(stderr, "%s is not a trace!\n", path);
+        } else if (file.header.version != capture::TRACE_FORMAT_VERSION) {
+            std::fprintf(stderr, "%s has unsupported version %u!\n", path, file.header.version);
+            ok = false;
+        }
+
+        capture::trace_span span;
+
+        // a span cut short by a crash is dropped
+        while (ok && std::fread(&span, sizeof(span), 1, stream) == 1) {
+            file.spans.push_back(span);
+        }
+
+        std::fclose(stream);
+        return ok;
+    }
+
+    std::string_view outcome_name(std::uint8_t outcome) {
+        if (outcome > static_cast<std::uint8_t>(server::frame_outcome::malformed)) {
+            return "?";
+        }
+
+        return server::to_string(static_cast<server::frame_outcome>(outcome));
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || std::strcmp(argv[1], "--help") == 0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<trace_file> files(argc - 1);
+
+    for (int i = 1; i < argc; i++) {
+        if (!read_trace(argv[i], files[i - 1])) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    // the steady clock starts at an arbitrary point, so times are shown relative to the first span
+    auto origin = std::numeric_limits<std::uint64_t>::max();
+
+    for (const auto &file: files) {
+        for (const auto &span: file.spans) {
+            origin = std::min(origin, span.begin);
+        }
+    }
+
+    std::printf("{\"traceEvents\":[\n");
+
+    auto first = true;
+
+    for (const auto &file: files) {
+        std::printf("%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"event loop %u\"}}",
+                    first ? "" : ",\n", file.header.shard, file.header.shard);
+        first = false;
+
+        for (const auto &span: file.spans) {
+            // microseconds, as the format wants, keeping the nanoseconds as decimals
+            std::printf(",\n{\"name\":\"type %u\",\"ph\":\"X\",\"pid\":%u,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f,"
+                        "\"args\":{\"outcome\":\"%.*s\"}}",
+                        span.type, file.header.shard, static_cast<unsigned long long>(span.connection_id),
+                        static_cast<double>(span.begin - origin) / 1000.0, static_cast<double>(span.duration) / 1000.0,
+                        static_cast<int>(outcome_name(span.outcome).size()), outcome_name(span.outcome).data());
+        }
+    }
+
+    std::printf("\n]}\n");
+    return EXIT_SUCCESS;
+}